@@ -66,6 +66,16 @@ bool FBaseCVar::m_UseCallback = false;
 
 FBaseCVar *CVars = NULL;
 
+// Case-insensitive hash index over CVars. Since cvars are mostly registered
+// by static constructors, this must be usable before any dynamic initialization
+// has run, so it is a plain zero-initialized array.
+enum { CVAR_HASH_SIZE = 1021 };
+static FBaseCVar *CVarHash[CVAR_HASH_SIZE];
+
+// Bumped every time a cvar is registered or removed, so that lookup caches
+// elsewhere (e.g. ACS) know when their resolved pointers may be stale.
+unsigned int CVarGeneration;
+
 int cvar_defflags;
 
 FBaseCVar::FBaseCVar (const FBaseCVar &var)
@@ -102,6 +112,11 @@ FBaseCVar::FBaseCVar (const char *var_name, DWORD flags, void (*callback)(FBaseC
 		Name = copystring (var_name);
 		m_Next = CVars;
 		CVars = this;
+
+		FBaseCVar **bucket = &CVarHash[MakeKey (var_name) % CVAR_HASH_SIZE];
+		m_HashNext = *bucket;
+		*bucket = this;
+		CVarGeneration++;
 	}
 
 	if (var)
@@ -140,6 +155,18 @@ FBaseCVar::~FBaseCVar ()
 			else
 				CVars = m_Next;
 		}
+
+		FBaseCVar **probe = &CVarHash[MakeKey (Name) % CVAR_HASH_SIZE];
+		while (*probe != NULL)
+		{
+			if (*probe == this)
+			{
+				*probe = m_HashNext;
+				break;
+			}
+			probe = &(*probe)->m_HashNext;
+		}
+		CVarGeneration++;
 		C_RemoveTabCommand(Name);
 		delete[] Name;
 	}
@@ -1456,16 +1483,32 @@ void C_ForgetCVars (void)
 	CVarBackups.Clear();
 }
 
+//===========================================================================
+//
+// FindCVar
+//
+// Looks up a cvar by name through the hash index. Only callers that need
+// the predecessor in the CVars list (i.e. for unlinking) pay for a walk
+// of the full list.
+//
+//===========================================================================
+
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev)
 {
 	FBaseCVar *var;
-	FBaseCVar *dummy;
 
 	if (var_name == NULL)
 		return NULL;
 
 	if (prev == NULL)
-		prev = &dummy;
+	{
+		for (var = CVarHash[MakeKey (var_name) % CVAR_HASH_SIZE]; var != NULL; var = var->m_HashNext)
+		{
+			if (stricmp (var->GetName (), var_name) == 0)
+				break;
+		}
+		return var;
+	}
 
 	var = CVars;
 	*prev = NULL;
@@ -1486,7 +1529,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 	if (var_name == NULL)
 		return NULL;
 
-	var = CVars;
+	var = CVarHash[MakeKey (var_name, namelen) % CVAR_HASH_SIZE];
 	while (var)
 	{
 		const char *probename = var->GetName ();
@@ -1496,14 +1539,27 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 		{
 			break;
 		}
-		var = var->m_Next;
+		var = var->m_HashNext;
 	}
 	return var;
 }
 
 FBaseCVar *GetCVar(AActor *activator, const char *cvarname)
 {
-	FBaseCVar *cvar = FindCVar(cvarname, nullptr);
+	return GetCVar(activator, FindCVar(cvarname, nullptr));
+}
+
+//===========================================================================
+//
+// GetCVar
+//
+// Variant for callers that have already resolved the cvar themselves and
+// only need the mod/userinfo filtering applied.
+//
+//===========================================================================
+
+FBaseCVar *GetCVar(AActor *activator, FBaseCVar *cvar)
+{
 	// Either the cvar doesn't exist, or it's for a mod that isn't loaded, so return nullptr.
 	if (cvar == nullptr || (cvar->GetFlags() & CVAR_IGNORE))
 	{
@@ -1518,7 +1574,7 @@ FBaseCVar *GetCVar(AActor *activator, const char *cvarname)
 			{
 				return nullptr;
 			}
-			return GetUserCVar(int(activator->player - players), cvarname);
+			return GetUserCVar(int(activator->player - players), cvar->GetName());
 		}
 		return cvar;
 	}
@@ -1695,11 +1751,11 @@ CCMD (unset)
 
 CCMD (get)
 {
-	FBaseCVar *var, *prev;
+	FBaseCVar *var;
 
 	if (argv.argc() >= 2)
 	{
-		if ( (var = FindCVar (argv[1], &prev)) )
+		if ( (var = FindCVar (argv[1], NULL)) )
 		{
 			UCVarValue val;
 			val = var->GetGenericRep (CVAR_String);
@@ -1718,12 +1774,12 @@ CCMD (get)
 
 CCMD (toggle)
 {
-	FBaseCVar *var, *prev;
+	FBaseCVar *var;
 	UCVarValue val;
 
 	if (argv.argc() > 1)
 	{
-		if ( (var = FindCVar (argv[1], &prev)) )
+		if ( (var = FindCVar (argv[1], NULL)) )
 		{
 			val = var->GetGenericRep (CVAR_Bool);
 			val.Bool = !val.Bool;
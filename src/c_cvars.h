@@ -151,6 +151,7 @@ private:
 
 	void (*m_Callback)(FBaseCVar &);
 	FBaseCVar *m_Next;
+	FBaseCVar *m_HashNext;
 
 	static bool m_UseCallback;
 	static bool m_DoNoSet;
@@ -189,6 +190,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen);
 
 // Used for ACS and DECORATE.
 FBaseCVar *GetCVar(AActor *activator, const char *cvarname);
+FBaseCVar *GetCVar(AActor *activator, FBaseCVar *cvar);
 FBaseCVar *GetUserCVar(int playernum, const char *cvarname);
 
 // Create a new cvar with the specified name and type
@@ -443,5 +445,6 @@ void C_ForgetCVars (void);
 #define EXTERN_CVAR(type,name) extern F##type##CVar name;
 
 extern FBaseCVar *CVars;
+extern unsigned int CVarGeneration;
 
 #endif //__C_CVARS_H__
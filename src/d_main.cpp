@@ -109,6 +109,7 @@
 #include "p_local.h"
 #include "autosegs.h"
 #include "fragglescript/t_fs.h"
+#include "profiler.h"
 
 EXTERN_CVAR(Bool, hud_althud)
 void DrawHUD();
@@ -644,6 +645,7 @@ CVAR (Flag, compat_clipmidtex,			compatflags2, COMPATF2_CLIPMIDTEX);
 
 void D_Display ()
 {
+	FProfileScope profile("Display");
 	bool wipe;
 	bool hw2d;
 
@@ -796,6 +798,7 @@ void D_Display ()
 				V_RefreshViewBorder ();
 			}
 
+			screen->BeginBatch2D();
 			if (hud_althud && realviewheight == SCREENHEIGHT && screenblocks > 10)
 			{
 				StatusBar->DrawBottomStuff (HUD_AltHud);
@@ -818,6 +821,7 @@ void D_Display ()
 				StatusBar->DrawTopStuff (HUD_StatusBar);
 			}
 			CT_Drawer ();
+			screen->EndBatch2D();
 			break;
 
 		case GS_INTERMISSION:
@@ -889,9 +893,11 @@ void D_Display ()
 	{
 		NetUpdate ();			// send out any new accumulation
 		// normal update
+		screen->BeginBatch2D ();
 		C_DrawConsole (hw2d);	// draw console
 		M_Drawer ();			// menu is drawn even on top of everything
 		FStat::PrintStat ();
+		screen->EndBatch2D ();
 		screen->Update ();		// page flip or blit buffer
 	}
 	else
@@ -991,7 +997,11 @@ void D_DoomLoop ()
 			}
 			
 			// process one or more tics
-			if (singletics)
+			if (G_RunDemoSeek ())
+			{
+				// fast-forwarding a demo
+			}
+			else if (singletics)
 			{
 				I_StartTic ();
 				D_ProcessEvents ();
@@ -166,8 +166,25 @@ CUSTOM_CVAR(Int, net_extratic, 0, CVAR_SERVERINFO | CVAR_NOSAVE)
 	}
 }
 
+// Every packet repeats at least this many of the most recent tics, so that
+// a lost packet is covered by the next one instead of waiting for a
+// retransmit request. The tics are delta coded and the packet compressed,
+// so repeating them is cheap.
+CUSTOM_CVAR(Int, net_resendwindow, 0, CVAR_SERVERINFO | CVAR_NOSAVE)
+{
+	if (self < 0)
+	{
+		self = 0;
+	}
+	else if (self > BACKUPTICS/2)
+	{
+		self = BACKUPTICS/2;
+	}
+}
+
 #ifdef _DEBUG
 CVAR(Int, net_fakelatency, 0, 0);
+CVAR(Int, net_fakeloss, 0, 0);		// percentage of outgoing packets to drop
 
 struct PacketStore
 {
@@ -521,6 +538,12 @@ void HSendPacket (int node, int len)
 	doomcom.datalength = len;
 
 #ifdef _DEBUG
+	if (net_fakeloss > 0 && rand() % 100 < net_fakeloss)
+	{
+		if (debugfile)
+			fprintf (debugfile, "Drop!\n");
+		return;
+	}
 	if (net_fakelatency / 2 > 0)
 	{
 		PacketStore store;
@@ -1170,6 +1193,10 @@ void NetUpdate (void)
 		case 1: resendto[i] = MAX(0, lowtic - 1); break;
 		case 2: resendto[i] = nettics[i]; break;
 		}
+		if (net_resendwindow > 0)
+		{
+			resendto[i] = MIN(resendto[i], MAX(0, lowtic - net_resendwindow));
+		}
 
 		if (numtics == 0 && resendOnly && !remoteresend[i] && nettics[i])
 		{
@@ -47,6 +47,7 @@
 #define UINF_ID		BIGE_ID('U','I','N','F')
 #define COMP_ID		BIGE_ID('C','O','M','P')
 #define BODY_ID		BIGE_ID('B','O','D','Y')
+#define KFRM_ID		BIGE_ID('K','F','R','M')
 #define NETD_ID		BIGE_ID('N','E','T','D')
 #define WEAP_ID		BIGE_ID('W','E','A','P')
 
@@ -359,6 +359,7 @@ static void MarkRoot()
 	}
 	Mark(SectorMarker);
 	Mark(interpolator.Head);
+	interpolator.MarkOffsetInterpolations();
 	// Mark action functions
 	if (!FinalGC)
 	{
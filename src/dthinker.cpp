@@ -40,11 +40,12 @@
 #include "doomerrors.h"
 #include "serializer.h"
 #include "d_player.h"
+#include "profiler.h"
 
 
 static cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
-extern cycle_t ActionCycles;
+extern cycle_t NativeActionCycles, ScriptActionCycles;
 extern int BotWTG;
 
 IMPLEMENT_CLASS (DThinker)
@@ -348,11 +349,13 @@ void DThinker::DestroyThinkersInList (FThinkerList &list)
 
 void DThinker::RunThinkers ()
 {
+	FProfileScope profile("Thinkers");
 	int i, count;
 
 	ThinkCycles.Reset();
 	BotSupportCycles.Reset();
-	ActionCycles.Reset();
+	NativeActionCycles.Reset();
+	ScriptActionCycles.Reset();
 	BotWTG = 0;
 
 	ThinkCycles.Clock();
@@ -527,6 +530,7 @@ DThinker *FThinkerIterator::Next ()
 ADD_STAT (think)
 {
 	FString out;
-	out.Format ("Think time = %04.2f ms, Action = %04.2f ms", ThinkCycles.TimeMS(), ActionCycles.TimeMS());
+	out.Format ("Think time = %04.2f ms, Action = %04.2f ms (native %04.2f ms, script %04.2f ms)", ThinkCycles.TimeMS(),
+		NativeActionCycles.TimeMS() + ScriptActionCycles.TimeMS(), NativeActionCycles.TimeMS(), ScriptActionCycles.TimeMS());
 	return out;
 }
@@ -102,6 +102,10 @@ const int SAVEPICHEIGHT = 162;
 bool	G_CheckDemoStatus (void);
 void	G_ReadDemoTiccmd (ticcmd_t *cmd, int player);
 void	G_WriteDemoTiccmd (ticcmd_t *cmd, int player, int buf);
+static void G_DemoKeyframeTicker ();
+static void G_ReadDemoKeyframes (BYTE *p, BYTE *end);
+static void G_WriteDemoKeyframes ();
+static void G_ClearDemoKeyframes ();
 void	G_PlayerReborn (int player);
 
 void	G_DoNewGame (void);
@@ -172,6 +176,8 @@ int 			consoleplayer;			// player taking events
 int 			gametic;
 
 CVAR(Bool, demo_compress, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+CVAR(Int, demo_keyframeinterval, 30, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);	// seconds between seek keyframes, 0 disables them
+CVAR(Bool, demo_savekeyframes, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);	// embed the keyframes in recorded demos
 FString			newdemoname;
 FString			newdemomap;
 FString			demoname;
@@ -186,6 +192,8 @@ BYTE*			demobodyspot;
 size_t			maxdemosize;
 BYTE*			zdemformend;			// end of FORM ZDEM chunk
 BYTE*			zdembodyend;			// end of ZDEM BODY chunk
+static BYTE*	zdembodystart;			// start of the (uncompressed) BODY data during playback
+static int		DemoTic;				// tics run since the demo started
 bool 			singledemo; 			// quit after playing a demo from cmdline 
  
 bool 			precache = true;		// if true, load all graphics at start 
@@ -1133,6 +1141,11 @@ void G_Ticker ()
 		}
 	}
 
+	if (demoplayback || demorecording)
+	{
+		G_DemoKeyframeTicker ();
+	}
+
 	// get commands, check consistancy, and build new consistancy check
 	int buf = (gametic/ticdup)%BACKUPTICS;
 
@@ -2472,6 +2485,9 @@ void G_BeginRecording (const char *startmap)
 	// Begin BODY chunk
 	StartChunk (BODY_ID, &demo_p);
 	demobodyspot = demo_p;
+
+	G_ClearDemoKeyframes ();
+	DemoTic = 0;
 }
 
 
@@ -2525,6 +2541,7 @@ bool G_ProcessIFFDemo (FString &mapname)
 	int id, len, i;
 	uLong uncompSize = 0;
 	BYTE *nextchunk;
+	BYTE *bodychunkend = NULL;
 
 	demoplayback = true;
 
@@ -2617,6 +2634,7 @@ bool G_ProcessIFFDemo (FString &mapname)
 		case BODY_ID:
 			bodyHit = true;
 			zdembodyend = demo_p + len;
+			bodychunkend = nextchunk;
 			break;
 
 		case COMP_ID:
@@ -2650,6 +2668,10 @@ bool G_ProcessIFFDemo (FString &mapname)
 	if (numPlayers > 1)
 		multiplayer = netgame = true;
 
+	// Keyframes are stored after the BODY, so older versions never see them.
+	// Read them before the body decompression frees the file buffer.
+	G_ReadDemoKeyframes (bodychunkend, zdemformend);
+
 	if (uncompSize > 0)
 	{
 		BYTE *uncompressed = (BYTE*)M_Malloc(uncompSize);
@@ -2665,6 +2687,8 @@ bool G_ProcessIFFDemo (FString &mapname)
 		demobuffer = demo_p = uncompressed;
 	}
 
+	zdembodystart = demo_p;
+	DemoTic = 0;
 	return false;
 }
 
@@ -2674,6 +2698,7 @@ void G_DoPlayDemo (void)
 	int demolump;
 
 	gameaction = ga_nothing;
+	G_ClearDemoKeyframes ();
 
 	// [RH] Allow for demos not loaded as lumps
 	demolump = Wads.CheckNumForFullName (defdemoname, true);
@@ -2783,6 +2808,7 @@ bool G_CheckDemoStatus (void)
 		C_RestoreCVars ();		// [RH] Restore cvars demo might have changed
 		M_Free (demobuffer);
 		demobuffer = NULL;
+		G_ClearDemoKeyframes ();
 
 		P_SetupWeapons_ntohton();
 		demoplayback = false;
@@ -2850,6 +2876,8 @@ bool G_CheckDemoStatus (void)
 			delete[] compressed;
 		}
 		FinishChunk (&demo_p);
+		G_WriteDemoKeyframes ();
+		G_ClearDemoKeyframes ();
 		formlen = demobuffer + 4;
 		WriteLong (int(demo_p - demobuffer - 8), &formlen);
 
@@ -2869,3 +2897,393 @@ bool G_CheckDemoStatus (void)
 
 	return false; 
 }
+
+//==========================================================================
+//
+// Demo keyframes
+//
+// Every demo_keyframeinterval seconds a compressed playsim snapshot is
+// taken along with the position in the demo's BODY, so that seeking only
+// has to restore the nearest keyframe and simulate the remaining tics.
+// Playback always takes one when the level starts, so seeking back works
+// even for demos without stored keyframes. The title loop only takes the
+// later ones once it has been seeked in, and timedemos take none.
+// When recording with demo_savekeyframes, the keyframes are appended to
+// the demo as KFRM chunks after the BODY. Older versions stop reading at
+// the BODY and never see them. Since the keyframes are savegame data they
+// are only used if they were written with the current SAVEVER.
+//
+//==========================================================================
+
+struct FDemoKeyframe
+{
+	int Tic;
+	unsigned BodyOffset;
+	usercmd_t Cmds[MAXPLAYERS];
+	FPlaysimSnapshot *Snapshot;
+};
+
+static TArray<FDemoKeyframe> DemoKeyframes;
+static int DemoSeekTic = -1;
+static bool DemoSeekUsed;		// keep capturing keyframes in the title loop
+
+enum { DEMOSEEK_FRAMETIME = 100 };	// ms of fast-forwarding per frame
+
+static void G_ClearDemoKeyframes ()
+{
+	for (unsigned i = 0; i < DemoKeyframes.Size(); i++)
+	{
+		delete DemoKeyframes[i].Snapshot;
+	}
+	DemoKeyframes.Clear();
+	DemoSeekTic = -1;
+	DemoSeekUsed = false;
+}
+
+//==========================================================================
+//
+// G_WantDemoKeyframe
+//
+//==========================================================================
+
+static bool G_WantDemoKeyframe ()
+{
+	if (gamestate != GS_LEVEL || gameaction != ga_nothing || demo_keyframeinterval <= 0)
+	{
+		return false;
+	}
+	if (DemoKeyframes.Size() == 0)
+	{
+		return demoplayback ? !timingdemo : demo_savekeyframes;
+	}
+	if (demoplayback ? timingdemo || (!singledemo && !DemoSeekUsed) : !demo_savekeyframes)
+	{
+		return false;
+	}
+	return DemoTic >= DemoKeyframes.Last().Tic + demo_keyframeinterval * TICRATE;
+}
+
+//==========================================================================
+//
+// G_DemoKeyframeTicker
+//
+// Called by G_Ticker before the demo commands for this tic are processed.
+//
+//==========================================================================
+
+static void G_DemoKeyframeTicker ()
+{
+	if (G_WantDemoKeyframe ())
+	{
+		FPlaysimSnapshot *snap = new FPlaysimSnapshot;
+		if (G_CapturePlaysim(*snap))
+		{
+			FDemoKeyframe kf;
+
+			kf.Tic = DemoTic;
+			kf.BodyOffset = unsigned(demo_p - (demoplayback ? zdembodystart : demobodyspot));
+			for (int i = 0; i < MAXPLAYERS; i++)
+			{
+				// DEM_EMPTYUSERCMD repeats the previous command, so it has to be kept as well.
+				kf.Cmds[i] = players[i].cmd.ucmd;
+			}
+			kf.Snapshot = snap;
+			DemoKeyframes.Push(kf);
+		}
+		else
+		{
+			delete snap;
+		}
+	}
+	DemoTic++;
+}
+
+//==========================================================================
+//
+// G_WriteDemoKeyframes
+//
+// Appends all keyframes as KFRM chunks to the demo being recorded.
+//
+//==========================================================================
+
+static void G_WriteDemoBuffer (const FCompressedBuffer &buff, BYTE **stream)
+{
+	WriteLong (buff.mSize, stream);
+	WriteLong (buff.mCompressedSize, stream);
+	WriteLong (buff.mMethod, stream);
+	WriteLong (buff.mCRC32, stream);
+	memcpy (*stream, buff.mBuffer, buff.mCompressedSize);
+	*stream += buff.mCompressedSize;
+}
+
+static void G_WriteDemoKeyframes ()
+{
+	size_t needed = 0;
+
+	for (unsigned i = 0; i < DemoKeyframes.Size(); i++)
+	{
+		const FPlaysimSnapshot *snap = DemoKeyframes[i].Snapshot;
+		needed += 64 + MAXPLAYERS * (sizeof(usercmd_t) + 8) + snap->MapName.Len() +
+			snap->Level.mCompressedSize + snap->Globals.mCompressedSize;
+	}
+	if (needed == 0)
+	{
+		return;
+	}
+
+	ptrdiff_t pos = demo_p - demobuffer;
+	if (pos + needed > maxdemosize)
+	{
+		ptrdiff_t spot = lenspot - demobuffer;
+		maxdemosize = pos + needed;
+		demobuffer = (BYTE *)M_Realloc (demobuffer, maxdemosize);
+		demo_p = demobuffer + pos;
+		lenspot = demobuffer + spot;
+		democompspot = demobodyspot = NULL;
+	}
+
+	for (unsigned i = 0; i < DemoKeyframes.Size(); i++)
+	{
+		const FDemoKeyframe &kf = DemoKeyframes[i];
+		int numplayers = 0;
+
+		for (int j = 0; j < MAXPLAYERS; j++)
+		{
+			numplayers += playeringame[j];
+		}
+
+		StartChunk (KFRM_ID, &demo_p);
+		WriteLong (SAVEVER, &demo_p);
+		WriteLong (kf.Tic, &demo_p);
+		WriteLong (kf.BodyOffset, &demo_p);
+		WriteString (kf.Snapshot->MapName, &demo_p);
+		WriteByte (numplayers, &demo_p);
+		for (int j = 0; j < MAXPLAYERS; j++)
+		{
+			if (playeringame[j])
+			{
+				WriteByte (j, &demo_p);
+				PackUserCmd (&kf.Cmds[j], NULL, &demo_p);
+			}
+		}
+		G_WriteDemoBuffer (kf.Snapshot->Level, &demo_p);
+		G_WriteDemoBuffer (kf.Snapshot->Globals, &demo_p);
+		FinishChunk (&demo_p);
+	}
+}
+
+//==========================================================================
+//
+// G_ReadDemoKeyframes
+//
+// Collects the KFRM chunks between the end of the BODY and the end of
+// the FORM.
+//
+//==========================================================================
+
+static bool G_ReadDemoBuffer (FCompressedBuffer &buff, BYTE **stream, BYTE *end)
+{
+	if (*stream + 16 > end)
+	{
+		return false;
+	}
+	buff.mSize = ReadLong (stream);
+	buff.mCompressedSize = ReadLong (stream);
+	buff.mMethod = ReadLong (stream);
+	buff.mCRC32 = ReadLong (stream);
+	if (buff.mCompressedSize > unsigned(end - *stream))
+	{
+		buff.mCompressedSize = 0;
+		return false;
+	}
+	buff.mBuffer = new char[buff.mCompressedSize];
+	memcpy (buff.mBuffer, *stream, buff.mCompressedSize);
+	*stream += buff.mCompressedSize;
+	return true;
+}
+
+static void G_ReadDemoKeyframes (BYTE *p, BYTE *end)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+	while (p + 8 <= end)
+	{
+		int id = ReadLong (&p);
+		int len = ReadLong (&p);
+
+		if (len < 0 || len > end - p)
+		{
+			break;
+		}
+		BYTE *nextchunk = p + len + (len & 1);
+		if (nextchunk > end)
+		{
+			nextchunk = end;
+		}
+		if (id == KFRM_ID && len >= 16 && ReadLong (&p) == SAVEVER)
+		{
+			FDemoKeyframe kf;
+			bool ok = false;
+
+			memset (kf.Cmds, 0, sizeof(kf.Cmds));
+			kf.Tic = ReadLong (&p);
+			kf.BodyOffset = ReadLong (&p);
+			kf.Snapshot = new FPlaysimSnapshot;
+
+			// Everything past this point is bounded by the chunk, a bad
+			// keyframe is dropped.
+			BYTE *nameend = (BYTE *)memchr (p, 0, nextchunk - p);
+			if (nameend != NULL && nameend + 1 < nextchunk)
+			{
+				kf.Snapshot->MapName = ReadStringConst (&p);
+
+				int numplayers = ReadByte (&p);
+				ok = numplayers <= MAXPLAYERS;
+				for (int i = 0; ok && i < numplayers; i++)
+				{
+					// a player number and a packed usercmd of at most 17 bytes
+					if (nextchunk - p < 18)
+					{
+						ok = false;
+						break;
+					}
+					int player = ReadByte (&p);
+					ok = player < MAXPLAYERS;
+					if (ok)
+					{
+						UnpackUserCmd (&kf.Cmds[player], NULL, &p);
+					}
+				}
+				ok = ok &&
+					G_ReadDemoBuffer (kf.Snapshot->Level, &p, nextchunk) &&
+					G_ReadDemoBuffer (kf.Snapshot->Globals, &p, nextchunk);
+			}
+
+			if (ok && (DemoKeyframes.Size() == 0 || kf.Tic > DemoKeyframes.Last().Tic))
+			{
+				DemoKeyframes.Push(kf);
+			}
+			else
+			{
+				delete kf.Snapshot;
+			}
+		}
+		p = nextchunk;
+	}
+}
+
+//==========================================================================
+//
+// G_RunDemoSeek
+//
+// Called by the main loop instead of running tics while a seek is pending.
+// Restores the closest keyframe before the target and simulates from there,
+// spreading the work over several frames if needed. Returns false if there
+// is nothing to seek.
+//
+//==========================================================================
+
+bool G_RunDemoSeek ()
+{
+	if (DemoSeekTic < 0)
+	{
+		return false;
+	}
+	if (!demoplayback)
+	{
+		DemoSeekTic = -1;
+		return false;
+	}
+	if (gameaction != ga_nothing)
+	{
+		return false;
+	}
+
+	FDemoKeyframe *best = NULL;
+	for (unsigned i = 0; i < DemoKeyframes.Size() && DemoKeyframes[i].Tic <= DemoSeekTic; i++)
+	{
+		best = &DemoKeyframes[i];
+	}
+
+	// Only restore if the keyframe gets us closer than simulating from where we are.
+	if (best != NULL && (DemoSeekTic < DemoTic || best->Tic > DemoTic))
+	{
+		if (!G_RestorePlaysim(*best->Snapshot))
+		{
+			Printf ("Could not restore demo keyframe\n");
+			DemoSeekTic = -1;
+			return false;
+		}
+		demo_p = zdembodystart + best->BodyOffset;
+		for (int i = 0; i < MAXPLAYERS; i++)
+		{
+			players[i].cmd.ucmd = best->Cmds[i];
+		}
+		DemoTic = best->Tic;
+		usergame = false;
+	}
+	else if (DemoSeekTic < DemoTic)
+	{
+		if (DemoKeyframes.Size() == 0)
+		{
+			Printf ("No demo keyframe to seek back to (demo_keyframeinterval is %d)\n", *demo_keyframeinterval);
+		}
+		else
+		{
+			Printf ("No demo keyframe to seek back to, the first one is at %.1f seconds\n", double(DemoKeyframes[0].Tic) / TICRATE);
+		}
+		DemoSeekTic = -1;
+		return false;
+	}
+
+	unsigned int starttime = I_MSTime();
+	while (demoplayback && DemoTic < DemoSeekTic && I_MSTime() - starttime < DEMOSEEK_FRAMETIME)
+	{
+		G_Ticker ();
+		gametic++;
+		maketic++;
+		GC::CheckGC ();
+	}
+	if (!demoplayback || DemoTic >= DemoSeekTic)
+	{
+		DemoSeekTic = -1;
+	}
+	return true;
+}
+
+static void G_SetDemoSeek (double seconds)
+{
+	if (!demoplayback)
+	{
+		Printf ("Not playing a demo\n");
+		return;
+	}
+	DemoSeekTic = MAX(0, int(seconds * TICRATE));
+	DemoSeekUsed = true;
+}
+
+CCMD (demoseek)
+{
+	if (argv.argc() < 2)
+	{
+		Printf ("Usage: demoseek <seconds>\n");
+		if (demoplayback)
+		{
+			Printf ("Demo position: %.1f seconds, %u keyframes\n", double(DemoTic) / TICRATE, DemoKeyframes.Size());
+		}
+		return;
+	}
+	G_SetDemoSeek (atof(argv[1]));
+}
+
+CCMD (demoskip)
+{
+	if (argv.argc() < 2)
+	{
+		Printf ("Usage: demoskip <seconds>\n");
+		return;
+	}
+	G_SetDemoSeek (double(DemoSeekTic >= 0 ? DemoSeekTic : DemoTic) / TICRATE + atof(argv[1]));
+}
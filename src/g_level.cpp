@@ -94,6 +94,7 @@
 
 void STAT_StartNewGame(const char *lev);
 void STAT_ChangeLevel(const char *newl);
+void STAT_Serialize(FSerializer &file);
 
 EXTERN_CVAR(Bool, save_formatted)
 EXTERN_CVAR (Float, sv_gravity)
@@ -101,6 +102,9 @@ EXTERN_CVAR (Float, sv_aircontrol)
 EXTERN_CVAR (Int, disableautosave)
 EXTERN_CVAR (String, playerclass)
 
+// zlib level for in-memory playsim snapshots, 0 to store them uncompressed.
+CVAR (Int, g_snapshotcompression, 1, CVAR_ARCHIVE)
+
 #define SNAP_ID			MAKE_ID('s','n','A','p')
 #define DSNP_ID			MAKE_ID('d','s','N','p')
 #define VIST_ID			MAKE_ID('v','i','S','t')
@@ -1603,6 +1607,99 @@ void G_UnSnapshotLevel (bool hubLoad)
 	}
 }
 
+//==========================================================================
+//
+// G_CapturePlaysim
+//
+// Stores the current level and all global playsim state in memory. This
+// uses the same serialization as savegames but skips everything that
+// is only needed for writing a file and only compresses lightly, since
+// it may be called often.
+//
+//==========================================================================
+
+bool G_CapturePlaysim (FPlaysimSnapshot &snap)
+{
+	if (gamestate != GS_LEVEL || level.info == nullptr || !level.info->isValid())
+	{
+		return false;
+	}
+
+	FSerializer arc, globals;
+
+	if (!arc.OpenWriter(false) || !globals.OpenWriter(false))
+	{
+		return false;
+	}
+	snap.Clean();
+	SaveVersion = SAVEVER;
+	G_SerializeLevel(arc, false);
+	snap.Level = arc.GetCompressedOutput(clamp<int>(g_snapshotcompression, 0, 9));
+
+	globals("leveltime", level.time);
+	STAT_Serialize(globals);
+	FRandom::StaticWriteRNGState(globals);
+	P_WriteACSDefereds(globals);
+	P_WriteACSVars(globals);
+	globals("nextskill", NextSkill);
+	snap.Globals = globals.GetCompressedOutput(clamp<int>(g_snapshotcompression, 0, 9));
+
+	snap.MapName = level.MapName;
+	return true;
+}
+
+//==========================================================================
+//
+// G_RestorePlaysim
+//
+// Reloads the snapshot's map and restores the state from the snapshot
+// the same way a savegame is loaded.
+//
+//==========================================================================
+
+bool G_RestorePlaysim (const FPlaysimSnapshot &snap)
+{
+	if (snap.Level.mBuffer == nullptr || snap.Globals.mBuffer == nullptr)
+	{
+		return false;
+	}
+	level_info_t *info = FindLevelInfo(snap.MapName);
+	if (info == nullptr)
+	{
+		return false;
+	}
+
+	FCompressedBuffer globalsbuf = snap.Globals;	// OpenReader doesn't modify the buffer
+	FSerializer arc;
+	if (!arc.OpenReader(&globalsbuf))
+	{
+		return false;
+	}
+
+	// G_InitNew consumes the level's snapshot so it gets a copy.
+	info->Snapshot.Clean();
+	info->Snapshot = snap.Level;
+	info->Snapshot.mBuffer = new char[snap.Level.mCompressedSize];
+	memcpy(info->Snapshot.mBuffer, snap.Level.mBuffer, snap.Level.mCompressedSize);
+
+	SaveVersion = SAVEVER;
+	bglobal.RemoveAllBots(true);
+	arc("leveltime", level.time);
+
+	savegamerestore = true;
+	bool demoplaybacksave = demoplayback;
+	G_InitNew(snap.MapName, false);
+	demoplayback = demoplaybacksave;
+	savegamerestore = false;
+
+	STAT_Serialize(arc);
+	FRandom::StaticReadRNGState(arc);
+	P_ReadACSDefereds(arc);
+	P_ReadACSVars(arc);
+	arc("nextskill", NextSkill);
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -537,6 +537,38 @@ void G_ReadSnapshots (FResourceFile *);
 void G_WriteSnapshots (TArray<FString> &, TArray<FCompressedBuffer> &);
 void G_WriteVisited(FSerializer &arc);
 void G_ReadVisited(FSerializer &arc);
+
+// In-memory copy of the playsim state that can be restored later, e.g. for
+// seeking in demos. Other levels of a hub are not included. gametic is not
+// part of it either, since it drives the tic loop; callers that need a
+// position keep their own count, like the demo code's DemoTic.
+struct FPlaysimSnapshot
+{
+	FString MapName;
+	FCompressedBuffer Level;
+	FCompressedBuffer Globals;
+
+	FPlaysimSnapshot()
+	{
+		Level = Globals = { 0, 0, 0, 0, 0, nullptr };
+	}
+	~FPlaysimSnapshot()
+	{
+		Clean();
+	}
+	void Clean()
+	{
+		Level.Clean();
+		Globals.Clean();
+	}
+
+private:
+	FPlaysimSnapshot(const FPlaysimSnapshot &) = delete;
+	FPlaysimSnapshot &operator=(const FPlaysimSnapshot &) = delete;
+};
+
+bool G_CapturePlaysim (FPlaysimSnapshot &snap);
+bool G_RestorePlaysim (const FPlaysimSnapshot &snap);
 void G_ClearHubInfo();
 
 enum ESkillProperty
@@ -1395,6 +1395,14 @@ public:
 			}
 			adjustRelCenter(x.RelCenter(), y.RelCenter(), *x, *y, ax, ay, xScale, yScale);
 		}
+
+		// Every character is drawn with the same tags, so only parse them once.
+		DrawParms parms, shadowparms;
+		if(!screen->ParseDrawParms(&parms, DTA_AlphaF, Alpha, TAG_DONE))
+			return;
+		if(drawshadow && !screen->ParseDrawParms(&shadowparms, DTA_AlphaF, Alpha * HR_SHADOW, DTA_FillColor, 0, TAG_DONE))
+			drawshadow = false;
+
 		while(*str != '\0')
 		{
 			if(*str == ' ')
@@ -1483,22 +1491,13 @@ public:
 			}
 			if(drawshadow)
 			{
-				double salpha = (Alpha *HR_SHADOW);
 				double srx = rx + (shadowX*xScale);
 				double sry = ry + (shadowY*yScale);
-				screen->DrawTexture(character, srx, sry,
-					DTA_DestWidthF, rw,
-					DTA_DestHeightF, rh,
-					DTA_AlphaF, salpha,
-					DTA_FillColor, 0,
-					TAG_DONE);
+				screen->DrawTextureResolved(character, srx, sry, rw, rh, shadowparms);
 			}
-			screen->DrawTexture(character, rx, ry,
-				DTA_DestWidthF, rw,
-				DTA_DestHeightF, rh,
-				DTA_Translation, remap,
-				DTA_AlphaF, Alpha,
-				TAG_DONE);
+			// Same as DTA_Translation: an inactive translation counts as none.
+			parms.remap = remap != NULL && !remap->Inactive ? remap : NULL;
+			screen->DrawTextureResolved(character, rx, ry, rw, rh, parms);
 			if(script->spacingCharacter == '\0')
 				ax += width + spacing - (character->LeftOffset+1);
 			else //width gets changed at the call to GetChar()
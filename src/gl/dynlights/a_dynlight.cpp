@@ -363,7 +363,7 @@ void ADynamicLight::UpdateLocation()
 			DVector3 pos = target->Vec3Offset(m_off.X * c + m_off.Y * s, m_off.X * s - m_off.Y * c, m_off.Z + target->GetBobOffset());
 			SetXYZ(pos); // attached lights do not need to go into the regular blockmap
 			Prev = target->Pos();
-			subsector = R_PointInSubsector(Prev);
+			subsector = R_PointInSubsector(Prev, subsector);
 			Sector = subsector->sector;
 		}
 
@@ -62,7 +62,7 @@ extern void ClearStrifeTypes();
 TArray<PClassActor *> PClassActor::AllActorClasses;
 FRandom FState::pr_statetics("StateTics");
 
-cycle_t ActionCycles;
+cycle_t NativeActionCycles, ScriptActionCycles;
 
 void FState::SetAction(const char *name)
 {
@@ -73,34 +73,39 @@ bool FState::CallAction(AActor *self, AActor *stateowner, FStateParamInfo *info,
 {
 	if (ActionFunc != NULL)
 	{
-		ActionCycles.Clock();
-
 		static VMFrameStack stack;
 		VMValue params[3] = { self, stateowner, VMValue(info, ATAG_STATEINFO) };
+		VMReturn ret;
+		int numret = 0;
+
 		// If the function returns a state, store it at *stateret.
 		// If it doesn't return a state but stateret is non-NULL, we need
 		// to set *stateret to NULL.
 		if (stateret != NULL)
 		{
 			*stateret = NULL;
-			if (ActionFunc->Proto == NULL ||
-				ActionFunc->Proto->ReturnTypes.Size() == 0 ||
-				ActionFunc->Proto->ReturnTypes[0] != TypeState)
+			if (ActionFunc->Proto != NULL &&
+				ActionFunc->Proto->ReturnTypes.Size() != 0 &&
+				ActionFunc->Proto->ReturnTypes[0] == TypeState)
 			{
-				stateret = NULL;
+				ret.PointerAt((void **)stateret);
+				numret = 1;
 			}
 		}
-		if (stateret == NULL)
+		if (ActionFunc->Native)
 		{
-			stack.Call(ActionFunc, params, countof(params), NULL, 0, NULL);
+			// Native functions need no frame, and VMFrameStack::Call would
+			// rethrow anything they throw, so call them directly.
+			NativeActionCycles.Clock();
+			static_cast<VMNativeFunction *>(ActionFunc)->NativeCall(&stack, params, countof(params), numret > 0 ? &ret : NULL, numret);
+			NativeActionCycles.Unclock();
 		}
 		else
 		{
-			VMReturn ret;
-			ret.PointerAt((void **)stateret);
-			stack.Call(ActionFunc, params, countof(params), &ret, 1, NULL);
+			ScriptActionCycles.Clock();
+			stack.Call(ActionFunc, params, countof(params), numret > 0 ? &ret : NULL, numret, NULL);
+			ScriptActionCycles.Unclock();
 		}
-		ActionCycles.Unclock();
 		return true;
 	}
 	else
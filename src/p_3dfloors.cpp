@@ -404,6 +404,105 @@ bool P_CheckFor3DCeilingHit(AActor * mo, double z)
 	return false;
 }
 
+//==========================================================================
+//
+// Sort key handling for P_Update3DFloors
+//
+//==========================================================================
+
+static unsigned SortKeyFlags(unsigned flags)
+{
+	// P_Recalculate3DFloors undoes the clipping before sorting, so this is what it starts with.
+	if (flags & FF_CLIPPED) flags = (flags & ~FF_CLIPPED) | FF_EXISTS;
+	return flags;
+}
+
+static void GetSortHeights(sector_t *sector, const TArray<F3DFloor *> &floors, TArray<double> &heights)
+{
+	heights.Resize(2 + floors.Size() * 2);
+	heights[0] = sector->ceilingplane.ZatPoint(sector->centerspot);
+	heights[1] = sector->floorplane.ZatPoint(sector->centerspot);
+	for (unsigned i = 0; i < floors.Size(); i++)
+	{
+		heights[2 + i * 2] = floors[i]->top.plane->ZatPoint(sector->centerspot);
+		heights[3 + i * 2] = floors[i]->bottom.plane->ZatPoint(sector->centerspot);
+	}
+}
+
+static void BuildSortKey(sector_t *sector)
+{
+	static TArray<double> heights;
+
+	extsector_t::xfloor &x = sector->e->XFloor;
+	F3DFloorSortKey &key = x.sortkey;
+
+	key.floors.Clear();
+	key.flags.Clear();
+	for (unsigned i = 0; i < x.ffloors.Size(); i++)
+	{
+		if (!(x.ffloors[i]->flags & FF_DYNAMIC))
+		{
+			key.floors.Push(x.ffloors[i]);
+			key.flags.Push(SortKeyFlags(x.ffloors[i]->flags));
+		}
+	}
+	GetSortHeights(sector, key.floors, heights);
+
+	// The floors are already sorted by their tops so this is mostly in order.
+	unsigned count = heights.Size();
+	key.order.Resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		WORD index = (WORD)i;
+		unsigned j = i;
+		while (j > 0 && heights[key.order[j - 1]] > heights[index])
+		{
+			key.order[j] = key.order[j - 1];
+			j--;
+		}
+		key.order[j] = index;
+	}
+	key.tied.Resize(count);
+	for (unsigned i = 0; i + 1 < count; i++)
+	{
+		key.tied[i] = heights[key.order[i]] == heights[key.order[i + 1]];
+	}
+}
+
+static bool SortKeyMatches(sector_t *sector)
+{
+	static TArray<F3DFloor *> floors;
+	static TArray<double> heights;
+
+	extsector_t::xfloor &x = sector->e->XFloor;
+	F3DFloorSortKey &key = x.sortkey;
+
+	floors.Clear();
+	for (unsigned i = 0; i < x.ffloors.Size(); i++)
+	{
+		F3DFloor *rover = x.ffloors[i];
+		if (!(rover->flags & FF_DYNAMIC))
+		{
+			unsigned n = floors.Size();
+			if (n >= key.floors.Size() || key.floors[n] != rover || key.flags[n] != SortKeyFlags(rover->flags))
+			{
+				return false;
+			}
+			floors.Push(rover);
+		}
+	}
+	if (floors.Size() != key.floors.Size()) return false;
+
+	GetSortHeights(sector, floors, heights);
+	for (unsigned i = 0; i + 1 < key.order.Size(); i++)
+	{
+		double h1 = heights[key.order[i]];
+		double h2 = heights[key.order[i + 1]];
+		if (key.tied[i] ? h1 != h2 : h1 >= h2) return false;
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // P_Recalculate3DFloors
@@ -586,6 +685,7 @@ void P_Recalculate3DFloors(sector_t * sector)
 	{
 		lightlist.Resize(1);
 		lightlist[0].plane = sector->ceilingplane;
+		lightlist[0].srcplane = &sector->ceilingplane;
 		lightlist[0].p_lightlevel = &sector->lightlevel;
 		lightlist[0].caster = NULL;
 		lightlist[0].lightsource = NULL;
@@ -609,6 +709,7 @@ void P_Recalculate3DFloors(sector_t * sector)
 			if (ff_top < maxheight)
 			{
 				newlight.plane = *rover->top.plane;
+				newlight.srcplane = rover->top.plane;
 				newlight.p_lightlevel = rover->toplightlevel;
 				newlight.caster = rover;
 				newlight.lightsource = rover;
@@ -650,6 +751,7 @@ void P_Recalculate3DFloors(sector_t * sector)
 				{
 					newlight.caster = rover;
 					newlight.plane = *rover->bottom.plane;
+					newlight.srcplane = rover->bottom.plane;
 					newlight.lightsource = resetlight.lightsource;
 					newlight.p_lightlevel = resetlight.p_lightlevel;
 					newlight.extra_colormap = resetlight.extra_colormap;
@@ -660,6 +762,35 @@ void P_Recalculate3DFloors(sector_t * sector)
 			}
 		}
 	}
+	BuildSortKey(sector);
+}
+
+//==========================================================================
+//
+// P_Update3DFloors
+//
+// Same as P_Recalculate3DFloors, but when the floors' heights have not
+// changed their order since the last rebuild, only the plane copies in the
+// light list get refreshed. Moving a platform inside its own gap, which is
+// what most elevators and water do, therefore does not resort anything.
+//
+//==========================================================================
+
+void P_Update3DFloors(sector_t *sector)
+{
+	extsector_t::xfloor &x = sector->e->XFloor;
+
+	if (x.ffloors.Size() == 0) return;
+	if (!SortKeyMatches(sector))
+	{
+		P_Recalculate3DFloors(sector);
+		return;
+	}
+	for (unsigned i = 0; i < x.lightlist.Size(); i++)
+	{
+		lightlist_t &ll = x.lightlist[i];
+		ll.plane = *ll.srcplane;
+	}
 }
 
 //==========================================================================
@@ -674,9 +805,9 @@ void P_RecalculateAttached3DFloors(sector_t * sec)
 
 	for(unsigned int i=0; i<x.attached.Size(); i++)
 	{
-		P_Recalculate3DFloors(x.attached[i]);
+		P_Update3DFloors(x.attached[i]);
 	}
-	P_Recalculate3DFloors(sec);
+	P_Update3DFloors(sec);
 }
 
 //==========================================================================
@@ -115,6 +115,19 @@ struct lightlist_t
 	int						flags;
 	F3DFloor*				lightsource;
 	F3DFloor*				caster;
+	const secplane_t *		srcplane;		// the plane that 'plane' was copied from
+};
+
+
+// What the last full rebuild of a sector's 3D floor list was based on.
+// As long as none of the heights change their order relative to each other
+// the sorting and clipping would produce the same result again.
+struct F3DFloorSortKey
+{
+	TArray<F3DFloor *>		floors;		// the non-dynamic floors in sorted order
+	TArray<unsigned>		flags;		// their flags, with FF_CLIPPED undone
+	TArray<WORD>			order;		// ceiling, floor, then top and bottom of each floor, lowest height first
+	TArray<BYTE>			tied;		// set if order[i] and order[i+1] have the same height
 };
 
 
@@ -125,6 +138,7 @@ void P_PlayerOnSpecial3DFloor(player_t* player);
 bool P_CheckFor3DFloorHit(AActor * mo, double z);
 bool P_CheckFor3DCeilingHit(AActor * mo, double z);
 void P_Recalculate3DFloors(sector_t *);
+void P_Update3DFloors(sector_t *);
 void P_RecalculateAttached3DFloors(sector_t * sec);
 void P_RecalculateLights(sector_t *sector);
 void P_RecalculateAttachedLights(sector_t *sector);
@@ -77,6 +77,7 @@
 #include "decallib.h"
 #include "p_terrain.h"
 #include "version.h"
+#include "stats.h"
 #include "p_effect.h"
 #include "r_utility.h"
 #include "a_morph.h"
@@ -84,6 +85,7 @@
 #include "serializer.h"
 
 #include "g_shared/a_pickups.h"
+#include "profiler.h"
 
 extern FILE *Logfile;
 
@@ -313,9 +315,9 @@ FACSStack::~FACSStack()
 //
 // Identical strings map to identical string identifiers.
 //
-// When the string table needs to grow to hold more strings, a garbage
-// collection is first attempted to see if more room can be made to store
-// strings without growing. A string is considered in use if any value
+// After as many strings have been created as were alive after the last
+// collection, a garbage collection is run. A string is considered in use
+// if any value
 // in any of these variable blocks contains a valid ID in the global string
 // table:
 //   * The active area of the ACS stack
@@ -327,6 +329,11 @@ FACSStack::~FACSStack()
 // that they might be. A string is also considered in use if its lock count
 // is non-zero, even if none of the above variable blocks referenced it.
 //
+// Most strings die young (think of HUD scripts that build a new string
+// every tic), so the automatic collections only sweep the strings created
+// since the previous one. Survivors are only looked at again by a full
+// collection, which happens once they have doubled in number.
+//
 // To keep track of local and map variables for nonresident maps in a hub,
 // when a map's state is archived, all strings found in its local and map
 // variables are locked. When a map is revisited in a hub, all strings found
@@ -363,8 +370,8 @@ void ACSStringPool::PoolEntry::Unlock()
 
 ACSStringPool::ACSStringPool()
 {
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	FirstFreeEntry = 0;
+	Clear();
+	NumMinorCollections = NumMajorCollections = 0;
 }
 
 //============================================================================
@@ -378,8 +385,14 @@ ACSStringPool::ACSStringPool()
 void ACSStringPool::Clear()
 {
 	Pool.Clear();
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
+	Young.Clear();
+	PoolBuckets.Resize(MIN_BUCKETS);
+	memset(&PoolBuckets[0], 0xFF, MIN_BUCKETS * sizeof(PoolBuckets[0]));
 	FirstFreeEntry = 0;
+	LiveCount = 0;
+	OldCount = OldCountAtMajor = 0;
+	GCThreshold = MIN_GC_SIZE;
+	MinorCollection = false;
 }
 
 //============================================================================
@@ -396,26 +409,24 @@ int ACSStringPool::AddString(const char *str)
 	if (str == nullptr) str = "";
 	size_t len = strlen(str);
 	unsigned int h = SuperFastHash(str, len);
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, len, h, bucketnum);
+	int i = FindString(str, len, h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
 	FString fstr(str);
-	return InsertString(fstr, h, bucketnum);
+	return InsertString(fstr, h);
 }
 
 int ACSStringPool::AddString(FString &str)
 {
 	unsigned int h = SuperFastHash(str.GetChars(), str.Len());
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, str.Len(), h, bucketnum);
+	int i = FindString(str, str.Len(), h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
-	return InsertString(str, h, bucketnum);
+	return InsertString(str, h);
 }
 
 //============================================================================
@@ -481,7 +492,7 @@ void ACSStringPool::MarkString(int strnum)
 	assert((strnum & LIBRARYID_MASK) == STRPOOL_LIBRARYID_OR);
 	strnum &= ~LIBRARYID_MASK;
 	assert((unsigned)strnum < Pool.Size());
-	Pool[strnum].Mark = true;
+	SetMark(strnum);
 }
 
 //============================================================================
@@ -554,7 +565,7 @@ void ACSStringPool::MarkStringArray(const int *strnum, unsigned int count)
 			num &= ~LIBRARYID_MASK;
 			if ((unsigned)num < Pool.Size())
 			{
-				Pool[num].Mark = true;
+				SetMark(num);
 			}
 		}
 	}
@@ -581,7 +592,7 @@ void ACSStringPool::MarkStringMap(const FWorldGlobalArray &aray)
 			num &= ~LIBRARYID_MASK;
 			if ((unsigned)num < Pool.Size())
 			{
-				Pool[num].Mark |= true;
+				SetMark(num);
 			}
 		}
 	}
@@ -615,10 +626,6 @@ void ACSStringPool::UnlockAll()
 
 void ACSStringPool::PurgeStrings()
 {
-	// Clear the hash buckets. We'll rebuild them as we decide what strings
-	// to keep and which to toss.
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	size_t usedcount = 0, freedcount = 0;
 	for (unsigned int i = 0; i < Pool.Size(); ++i)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -626,28 +633,167 @@ void ACSStringPool::PurgeStrings()
 		{
 			if (entry->Locks.Size() == 0 && !entry->Mark)
 			{
-				freedcount++;
-				// Mark this entry as free.
-				entry->Next = FREE_ENTRY;
-				if (i < FirstFreeEntry)
-				{
-					FirstFreeEntry = i;
-				}
-				// And free the string.
-				entry->Str = "";
+				FreeEntry(i);
 			}
 			else
 			{
-				usedcount++;
-				// Rehash this entry.
-				unsigned int h = entry->Hash % NUM_BUCKETS;
-				entry->Next = PoolBuckets[h];
-				PoolBuckets[h] = i;
 				// Remove MarkString's mark.
 				entry->Mark = false;
+				entry->Young = false;
 			}
 		}
 	}
+	Young.Clear();
+	OldCount = OldCountAtMajor = LiveCount;
+	GCThreshold = MAX<unsigned>(MIN_GC_SIZE, LiveCount);
+	MinorCollection = false;
+
+	// The freed entries are still linked into the hash buckets, so they
+	// need to be rebuilt.
+	Rehash();
+}
+
+//============================================================================
+//
+// ACSStringPool :: PurgeYoungStrings
+//
+// Remove all unlocked strings that were created since the last collection.
+// The older strings were not marked, so they cannot be looked at.
+//
+//============================================================================
+
+void ACSStringPool::PurgeYoungStrings()
+{
+	for (unsigned int i = 0; i < Young.Size(); ++i)
+	{
+		unsigned int index = Young[i];
+		PoolEntry *entry = &Pool[index];
+		assert(entry->Next != FREE_ENTRY && entry->Young);
+
+		if (entry->Locks.Size() == 0 && !entry->Mark)
+		{
+			// Unlink it from its hash bucket.
+			unsigned int *link = &PoolBuckets[entry->Hash & (PoolBuckets.Size() - 1)];
+			while (*link != index)
+			{
+				link = &Pool[*link].Next;
+			}
+			*link = entry->Next;
+			FreeEntry(index);
+		}
+		else
+		{
+			entry->Mark = false;
+			entry->Young = false;
+			OldCount++;
+		}
+	}
+	Young.Clear();
+	GCThreshold = MAX<unsigned>(MIN_GC_SIZE, LiveCount);
+	MinorCollection = false;
+}
+
+//============================================================================
+//
+// ACSStringPool :: BeginCollection
+//
+// Decides whether the next collection only needs to look at young strings.
+// Returns true if it does.
+//
+//============================================================================
+
+bool ACSStringPool::BeginCollection(bool full)
+{
+	MinorCollection = !full && OldCount <= OldCountAtMajor * 2 + MIN_GC_SIZE;
+	return MinorCollection;
+}
+
+//============================================================================
+//
+// ACSStringPool :: EndCollection
+//
+// Removes everything that was not marked since BeginCollection.
+//
+//============================================================================
+
+void ACSStringPool::EndCollection()
+{
+	if (MinorCollection)
+	{
+		PurgeYoungStrings();
+		NumMinorCollections++;
+	}
+	else
+	{
+		PurgeStrings();
+		NumMajorCollections++;
+	}
+}
+
+//============================================================================
+//
+// ACSStringPool :: FreeEntry
+//
+// Marks an entry as free. Unlinking it from its hash bucket is up to the
+// caller.
+//
+//============================================================================
+
+void ACSStringPool::FreeEntry(unsigned int index)
+{
+	PoolEntry *entry = &Pool[index];
+
+	entry->Next = FREE_ENTRY;
+	entry->Young = false;
+	entry->Str = "";
+	if (index < FirstFreeEntry)
+	{
+		FirstFreeEntry = index;
+	}
+	LiveCount--;
+}
+
+//============================================================================
+//
+// ACSStringPool :: Rehash
+//
+// Rebuilds the hash buckets, with one bucket per string.
+//
+//============================================================================
+
+void ACSStringPool::Rehash()
+{
+	unsigned int size = MIN_BUCKETS;
+	while (size < LiveCount)
+	{
+		size <<= 1;
+	}
+	PoolBuckets.Resize(size);
+	memset(&PoolBuckets[0], 0xFF, size * sizeof(PoolBuckets[0]));
+	for (unsigned int i = 0; i < Pool.Size(); ++i)
+	{
+		PoolEntry *entry = &Pool[i];
+		if (entry->Next != FREE_ENTRY)
+		{
+			unsigned int bucketnum = entry->Hash & (size - 1);
+			entry->Next = PoolBuckets[bucketnum];
+			PoolBuckets[bucketnum] = i;
+		}
+	}
+}
+
+//============================================================================
+//
+// ACSStringPool :: GetStats
+//
+//============================================================================
+
+FString ACSStringPool::GetStats() const
+{
+	FString out;
+	out.Format("%u strings (%u new), %u slots, %u buckets, %u minor/%u full collections",
+		LiveCount, Young.Size(), Pool.Size(), PoolBuckets.Size(), NumMinorCollections, NumMajorCollections);
+	return out;
 }
 
 //============================================================================
@@ -659,9 +805,9 @@ void ACSStringPool::PurgeStrings()
 //
 //============================================================================
 
-int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::FindString(const char *str, size_t len, unsigned int h)
 {
-	unsigned int i = PoolBuckets[bucketnum];
+	unsigned int i = PoolBuckets[h & (PoolBuckets.Size() - 1)];
 	while (i != NO_ENTRY)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -684,14 +830,13 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 //
 //============================================================================
 
-int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::InsertString(FString &str, unsigned int h)
 {
-	unsigned int index = FirstFreeEntry;
-	if (index >= MIN_GC_SIZE && index == Pool.Max())
-	{ // We will need to grow the array. Try a garbage collection first.
-		P_CollectACSGlobalStrings();
-		index = FirstFreeEntry;
+	if (Young.Size() >= GCThreshold)
+	{ // Enough new strings have piled up to make a collection worthwhile.
+		P_CollectACSGlobalStrings(false);
 	}
+	unsigned int index = FirstFreeEntry;
 	if (FirstFreeEntry >= STRPOOL_LIBRARYID_OR)
 	{ // If we go any higher, we'll collide with the library ID marker.
 		return -1;
@@ -708,10 +853,22 @@ int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucke
 	PoolEntry *entry = &Pool[index];
 	entry->Str = str;
 	entry->Hash = h;
-	entry->Next = PoolBuckets[bucketnum];
 	entry->Mark = false;
+	entry->Young = true;
 	entry->Locks.Clear();
-	PoolBuckets[bucketnum] = index;
+	Young.Push(index);
+	LiveCount++;
+	if (LiveCount > PoolBuckets.Size() * 2)
+	{
+		entry->Next = NO_ENTRY;
+		Rehash();
+	}
+	else
+	{
+		unsigned int bucketnum = h & (PoolBuckets.Size() - 1);
+		entry->Next = PoolBuckets[bucketnum];
+		PoolBuckets[bucketnum] = index;
+	}
 	return index | STRPOOL_LIBRARYID_OR;
 }
 
@@ -754,6 +911,7 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 		{
 			p.Next = FREE_ENTRY;
 			p.Mark = false;
+			p.Young = false;
 			p.Locks.Clear();
 		}
 		if (file.BeginArray("pool"))
@@ -770,11 +928,12 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 						file("string", Pool[ii].Str)
 							("locks", Pool[ii].Locks);
 
-						unsigned h = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
-						unsigned bucketnum = h % NUM_BUCKETS;
-						Pool[ii].Hash = h;
-						Pool[ii].Next = PoolBuckets[bucketnum];
-						PoolBuckets[bucketnum] = ii;
+						if (Pool[ii].Next == FREE_ENTRY)
+						{
+							LiveCount++;
+						}
+						Pool[ii].Hash = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
+						Pool[ii].Next = NO_ENTRY;	// linked by Rehash below
 					}
 					file.EndObject();
 				}
@@ -782,6 +941,9 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 		}
 	}
 
+	OldCount = OldCountAtMajor = LiveCount;
+	GCThreshold = MAX<unsigned>(MIN_GC_SIZE, LiveCount);
+	Rehash();
 	FindFirstFreeEntry(FirstFreeEntry);
 }
 
@@ -900,8 +1062,13 @@ void P_MarkGlobalVarStrings()
 //
 //============================================================================
 
-void P_CollectACSGlobalStrings()
+static cycle_t ACSStringGCCycles;
+
+void P_CollectACSGlobalStrings(bool full)
 {
+	ACSStringGCCycles.Reset();
+	ACSStringGCCycles.Clock();
+	GlobalACSStrings.BeginCollection(full);
 	for (FACSStack *stack = FACSStack::head; stack != NULL; stack = stack->next)
 	{
 		const SDWORD sp = stack->sp;
@@ -922,7 +1089,15 @@ void P_CollectACSGlobalStrings()
 	FBehavior::StaticMarkLevelVarStrings();
 	P_MarkWorldVarStrings();
 	P_MarkGlobalVarStrings();
-	GlobalACSStrings.PurgeStrings();
+	GlobalACSStrings.EndCollection();
+	ACSStringGCCycles.Unclock();
+}
+
+ADD_STAT(acsstrings)
+{
+	FString out = GlobalACSStrings.GetStats();
+	out.AppendFormat(", last collection %04.2f ms", ACSStringGCCycles.TimeMS());
+	return out;
 }
 
 #ifdef _DEBUG
@@ -2988,6 +3163,7 @@ void DACSThinker::Serialize(FSerializer &arc)
 
 void DACSThinker::Tick ()
 {
+	FProfileScope profile("ACS");
 	DLevelScript *script = Scripts;
 
 	while (script)
@@ -4591,6 +4767,47 @@ static void DoSetCVar(FBaseCVar *cvar, int value, bool is_string, bool force=fal
 	}
 }
 
+//============================================================================
+//
+// FindACSCVar
+//
+// Resolves a cvar named by an ACS string. Scripts tend to poll the same few
+// cvars every tic, so the result is cached per string index. String indices
+// can be recycled (pool purges, module reloads), so a cached entry is only
+// trusted if its name still matches, and the whole cache is dropped whenever
+// the cvar set changes.
+//
+//============================================================================
+
+static TMap<DWORD, FBaseCVar *> ACSCVarCache;
+static unsigned int ACSCVarCacheGeneration;
+
+static FBaseCVar *FindACSCVar(DWORD strnum)
+{
+	const char *name = FBehavior::StaticLookupString(strnum);
+
+	if (name == NULL)
+	{
+		return NULL;
+	}
+	if (ACSCVarCacheGeneration != CVarGeneration)
+	{
+		ACSCVarCache.Clear();
+		ACSCVarCacheGeneration = CVarGeneration;
+	}
+	FBaseCVar **cached = ACSCVarCache.CheckKey(strnum);
+	if (cached != NULL && stricmp((*cached)->GetName(), name) == 0)
+	{
+		return *cached;
+	}
+	FBaseCVar *cvar = FindCVar(name, NULL);
+	if (cvar != NULL)
+	{
+		ACSCVarCache[strnum] = cvar;
+	}
+	return cvar;
+}
+
 // Converts floating- to fixed-point as required.
 static int DoGetCVar(FBaseCVar *cvar, bool is_string)
 {
@@ -5301,7 +5518,7 @@ int DLevelScript::CallFunction(int argCount, int funcIndex, SDWORD *args)
 		case ACSF_GetCVarString:
 			if (argCount == 1)
 			{
-				return DoGetCVar(GetCVar(activator, FBehavior::StaticLookupString(args[0])), true);
+				return DoGetCVar(GetCVar(activator, FindACSCVar(args[0])), true);
 			}
 			break;
 
@@ -9137,7 +9354,7 @@ scriptwait:
 			break;
 
 		case PCD_GETCVAR:
-			STACK(1) = DoGetCVar(GetCVar(activator, FBehavior::StaticLookupString(STACK(1))), false);
+			STACK(1) = DoGetCVar(GetCVar(activator, FindACSCVar(STACK(1))), false);
 			break;
 
 		case PCD_SETHUDSIZE:
@@ -120,12 +120,28 @@ public:
 	void ReadStrings(FSerializer &file, const char *key);
 	void WriteStrings(FSerializer &file, const char *key) const;
 
+	// Automatic collections are generational: Unless the surviving strings
+	// have piled up, only the strings created since the last collection
+	// are considered, and marking in between only affects those.
+	bool BeginCollection(bool full);
+	void EndCollection();
+	FString GetStats() const;
+
 private:
-	int FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum);
-	int InsertString(FString &str, unsigned int h, unsigned int bucketnum);
+	int FindString(const char *str, size_t len, unsigned int h);
+	int InsertString(FString &str, unsigned int h);
 	void FindFirstFreeEntry(unsigned int base);
+	void FreeEntry(unsigned int index);
+	void Rehash();
+	void SetMark(unsigned int index)
+	{
+		if (!MinorCollection || Pool[index].Young)
+		{
+			Pool[index].Mark = true;
+		}
+	}
 
-	enum { NUM_BUCKETS = 251 };
+	enum { MIN_BUCKETS = 256 };			// Must be a power of 2
 	enum { FREE_ENTRY = 0xFFFFFFFE };	// Stored in PoolEntry's Next field
 	enum { NO_ENTRY = 0xFFFFFFFF };
 	enum { MIN_GC_SIZE = 100 };			// Don't auto-collect until there are this many strings
@@ -135,18 +151,29 @@ private:
 		unsigned int Hash;
 		unsigned int Next = FREE_ENTRY;
 		bool Mark;
+		bool Young;
 		TArray<int> Locks;
 
 		void Lock();
 		void Unlock();
 	};
 	TArray<PoolEntry> Pool;
-	unsigned int PoolBuckets[NUM_BUCKETS];
+	TArray<unsigned int> PoolBuckets;
+	TArray<unsigned int> Young;			// Strings created since the last collection
 	unsigned int FirstFreeEntry;
+	unsigned int LiveCount;
+	unsigned int OldCount;				// Strings that survived a collection
+	unsigned int OldCountAtMajor;
+	unsigned int GCThreshold;			// Collect when this many strings were created
+	bool MinorCollection;
+	unsigned int NumMinorCollections;
+	unsigned int NumMajorCollections;
+
+	void PurgeYoungStrings();
 };
 extern ACSStringPool GlobalACSStrings;
 
-void P_CollectACSGlobalStrings();
+void P_CollectACSGlobalStrings(bool full = true);
 void P_ReadACSVars(FSerializer &);
 void P_WriteACSVars(FSerializer &);
 void P_ClearACSVars(bool);
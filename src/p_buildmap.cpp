@@ -385,7 +385,7 @@ static bool P_LoadBloodMap (BYTE *data, size_t len, FMapThing **mapthings, int *
 
 static void LoadSectors (sectortype *bsec)
 {
-	FDynamicColormap *map = GetSpecialLights (PalEntry (255,255,255), level.fadeto, 0);
+	FDynamicColormap *map = GetSpecialLights (PalEntry (255,255,255), level.fadeto, 0, true);
 	sector_t *sec;
 	char tnam[9];
 
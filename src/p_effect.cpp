@@ -53,6 +53,17 @@
 #include "colormatcher.h"
 #include "d_player.h"
 #include "r_utility.h"
+#include "portal.h"
+#include "profiler.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
 CVAR (Int, cl_rockettrails, 1, CVAR_ARCHIVE);
 CVAR (Bool, r_rail_smartspiral, 0, CVAR_ARCHIVE);
@@ -65,11 +76,20 @@ FRandom pr_railtrail("RailTrail");
 #define FADEFROMTTL(a)	(1.f/(a))
 
 // [RH] particle globals
-WORD			NumParticles;
-WORD			ActiveParticles;
-WORD			InactiveParticles;
+DWORD			NumParticles;
+DWORD			ActiveParticles;
+DWORD			InactiveParticles;
 particle_t		*Particles;
-TArray<WORD>	ParticlesInSubsec;
+TArray<DWORD>	ParticlesInSubsec;
+
+// Indices of the particles that need to be moved this tic
+static TArray<DWORD> ParticleBatch;
+
+const int MAX_PARTICLES = 1000000;
+
+// Below this many moving particles it isn't worth splitting the work up.
+const unsigned PARTICLE_THREAD_BATCH = 16384;
+const unsigned MAX_PARTICLE_THREADS = 8;
 
 static int grey1, grey2, grey3, grey4, red, green, blue, yellow, black,
 		   red1, green1, blue1, yellow1, purple, purple1, white,
@@ -117,7 +137,7 @@ inline particle_t *NewParticle (void)
 		result = Particles + InactiveParticles;
 		InactiveParticles = result->tnext;
 		result->tnext = ActiveParticles;
-		ActiveParticles = WORD(result - Particles);
+		ActiveParticles = DWORD(result - Particles);
 	}
 	return result;
 }
@@ -134,8 +154,8 @@ CUSTOM_CVAR( Int, r_maxparticles, 4000, CVAR_ARCHIVE )
 {
 	if ( self == 0 )
 		self = 4000;
-	else if (self > 65535)
-		self = 65535;
+	else if (self > MAX_PARTICLES)
+		self = MAX_PARTICLES;
 	else if (self < 100)
 		self = 100;
 
@@ -158,7 +178,7 @@ void P_InitParticles ()
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	NumParticles = (WORD)clamp<int>(num, 100, 65535);
+	NumParticles = (DWORD)clamp<int>(num, 100, MAX_PARTICLES);
 
 	P_DeinitParticles();
 	Particles = new particle_t[NumParticles];
@@ -177,7 +197,7 @@ void P_DeinitParticles()
 
 void P_ClearParticles ()
 {
-	int i;
+	DWORD i;
 
 	memset (Particles, 0, NumParticles * sizeof(particle_t));
 	ActiveParticles = NO_PARTICLE;
@@ -198,13 +218,13 @@ void P_FindParticleSubsectors ()
 		ParticlesInSubsec.Reserve (numsubsectors - ParticlesInSubsec.Size());
 	}
 
-	clearbufshort (&ParticlesInSubsec[0], numsubsectors, NO_PARTICLE);
+	clearbuf (&ParticlesInSubsec[0], numsubsectors, NO_PARTICLE);
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (WORD i = ActiveParticles; i != NO_PARTICLE; i = Particles[i].tnext)
+	for (DWORD i = ActiveParticles; i != NO_PARTICLE; i = Particles[i].tnext)
 	{
 		 // Try to reuse the subsector from the last portal check, if still valid.
 		if (Particles[i].subsector == NULL) Particles[i].subsector = R_PointInSubsector(Particles[i].Pos);
@@ -252,18 +272,209 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
+//==========================================================================
+//
+// P_MoveParticles
+//
+// Moves a range of the particles collected by P_ThinkParticles. This only
+// reads level data, so without line portals (whose traverser uses shared
+// state) it can run on several threads at once.
+//
+//==========================================================================
+
+static void P_MoveParticles(unsigned start, unsigned end, bool lineportals)
+{
+	for (unsigned j = start; j < end; j++)
+	{
+		particle_t *particle = Particles + ParticleBatch[j];
+
+		if (lineportals)
+		{
+			// Handle crossing a line portal
+			DVector2 newxy = P_GetOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
+			particle->Pos.X = newxy.X;
+			particle->Pos.Y = newxy.Y;
+			particle->Pos.Z += particle->Vel.Z;
+			particle->Vel += particle->Acc;
+		}
+		else
+		{
+#ifndef NO_SSE
+			__m128d pos = _mm_loadu_pd(&particle->Pos.X);
+			__m128d vel = _mm_loadu_pd(&particle->Vel.X);
+			__m128d acc = _mm_loadu_pd(&particle->Acc.X);
+			_mm_storeu_pd(&particle->Pos.X, _mm_add_pd(pos, vel));
+			_mm_storeu_pd(&particle->Vel.X, _mm_add_pd(vel, acc));
+			particle->Pos.Z += particle->Vel.Z;
+			particle->Vel.Z += particle->Acc.Z;
+#else
+			particle->Pos += particle->Vel;
+			particle->Vel += particle->Acc;
+#endif
+		}
+
+		subsector_t *ss = R_PointInSubsector(particle->Pos, particle->subsector);
+		particle->subsector = ss;
+
+		sector_t *s = ss->sector;
+		// Handle crossing a sector portal.
+		if (!s->PortalBlocksMovement(sector_t::ceiling))
+		{
+			if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
+			{
+				particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
+				particle->subsector = NULL;
+			}
+		}
+		else if (!s->PortalBlocksMovement(sector_t::floor))
+		{
+			if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
+			{
+				particle->Pos += s->GetPortalDisplacement(sector_t::floor);
+				particle->subsector = NULL;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// FParticleWorkers
+//
+// Threads that move a share of the particle batch. They are started the
+// first time a batch is big enough to split and then sleep until the next
+// tic, the same way the drawer threads wait for the next frame.
+//
+//==========================================================================
+
+class FParticleWorkers
+{
+public:
+	~FParticleWorkers() { StopThreads(); }
+	void Run(unsigned count, unsigned numthreads);
+
+private:
+	void StartThreads();
+	void StopThreads();
+
+	std::vector<std::thread> threads;
+
+	std::mutex start_mutex;
+	std::condition_variable start_condition;
+	bool shutdown_flag = false;
+	int run_id = 0;
+	unsigned run_count = 0;
+	unsigned run_chunk = 0;
+
+	std::mutex end_mutex;
+	std::condition_variable end_condition;
+	size_t finished_threads = 0;
+};
+
+static FParticleWorkers ParticleWorkers;
+
+void FParticleWorkers::StartThreads()
+{
+	if (!threads.empty())
+		return;
+
+	unsigned num_threads = MIN(std::thread::hardware_concurrency(), MAX_PARTICLE_THREADS);
+	threads.resize(num_threads - 1);
+
+	for (unsigned i = 0; i < num_threads - 1; i++)
+	{
+		unsigned core = i + 1;
+		threads[i] = std::thread([=]()
+		{
+			FString name;
+			name.Format("Particles %u", core);
+			Prof_SetThreadName(name);
+
+			int last_run = 0;
+			while (true)
+			{
+				// Wait until we are signalled to run:
+				std::unique_lock<std::mutex> start_lock(start_mutex);
+				start_condition.wait(start_lock, [&]() { return run_id != last_run || shutdown_flag; });
+				if (shutdown_flag)
+					break;
+				last_run = run_id;
+				unsigned count = run_count;
+				unsigned chunk = run_chunk;
+				start_lock.unlock();
+
+				// Threads past the end of the batch have nothing to do this tic.
+				if (core * chunk < count)
+				{
+					P_MoveParticles(core * chunk, MIN(count, (core + 1) * chunk), false);
+				}
+
+				// Notify the playsim that we finished:
+				std::unique_lock<std::mutex> end_lock(end_mutex);
+				finished_threads++;
+				end_lock.unlock();
+				end_condition.notify_all();
+			}
+		});
+	}
+}
+
+void FParticleWorkers::StopThreads()
+{
+	std::unique_lock<std::mutex> lock(start_mutex);
+	shutdown_flag = true;
+	lock.unlock();
+	start_condition.notify_all();
+	for (auto &thread : threads)
+		thread.join();
+	threads.clear();
+	lock.lock();
+	shutdown_flag = false;
+}
+
+void FParticleWorkers::Run(unsigned count, unsigned numthreads)
+{
+	StartThreads();
+
+	unsigned chunk = (count + numthreads - 1) / numthreads;
+	std::unique_lock<std::mutex> start_lock(start_mutex);
+	run_count = count;
+	run_chunk = chunk;
+	run_id++;
+	start_lock.unlock();
+	start_condition.notify_all();
+
+	// Do the first share ourselves:
+	P_MoveParticles(0, MIN(count, chunk), false);
+
+	std::unique_lock<std::mutex> end_lock(end_mutex);
+	end_condition.wait(end_lock, [&]() { return finished_threads == threads.size(); });
+	finished_threads = 0;
+}
+
+//==========================================================================
+//
+// P_ThinkParticles
+//
+// Ages all particles and frees the expired ones, then moves the rest
+// as a batch.
+//
+//==========================================================================
+
 void P_ThinkParticles ()
 {
-	int i;
+	DWORD i;
 	particle_t *particle, *prev;
+	bool frozen = bglobal.freeze || (level.flags2 & LEVEL2_FROZEN);
 
+	ParticleBatch.Clear();
 	i = ActiveParticles;
 	prev = NULL;
 	while (i != NO_PARTICLE)
 	{
 		particle = Particles + i;
 		i = particle->tnext;
-		if (!particle->notimefreeze && ((bglobal.freeze) || (level.flags2 & LEVEL2_FROZEN)))
+		if (!particle->notimefreeze && frozen)
 		{
 			prev = particle;
 			continue;
@@ -280,37 +491,29 @@ void P_ThinkParticles ()
 			else
 				ActiveParticles = i;
 			particle->tnext = InactiveParticles;
-			InactiveParticles = (int)(particle - Particles);
+			InactiveParticles = DWORD(particle - Particles);
 			continue;
 		}
-
-		// Handle crossing a line portal
-		DVector2 newxy = P_GetOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
-		particle->Pos.X = newxy.X;
-		particle->Pos.Y = newxy.Y;
-		particle->Pos.Z += particle->Vel.Z;
-		particle->Vel += particle->Acc;
-		particle->subsector = R_PointInSubsector(particle->Pos);
-		sector_t *s = particle->subsector->sector;
-		// Handle crossing a sector portal.
-		if (!s->PortalBlocksMovement(sector_t::ceiling))
-		{
-			if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
-				particle->subsector = NULL;
-			}
-		}
-		else if (!s->PortalBlocksMovement(sector_t::floor))
-		{
-			if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::floor);
-				particle->subsector = NULL;
-			}
-		}
+		ParticleBatch.Push(DWORD(particle - Particles));
 		prev = particle;
 	}
+
+	unsigned count = ParticleBatch.Size();
+	bool lineportals = PortalBlockmap.containsLines;
+	unsigned numthreads = 1;
+
+	if (!lineportals && count >= 2 * PARTICLE_THREAD_BATCH)
+	{
+		numthreads = MIN(MIN(std::thread::hardware_concurrency(), MAX_PARTICLE_THREADS), count / PARTICLE_THREAD_BATCH);
+	}
+	if (numthreads <= 1)
+	{
+		P_MoveParticles(0, count, lineportals);
+	}
+	else
+	{
+		ParticleWorkers.Run(count, numthreads);
+	}
 }
 
 enum PSFlag
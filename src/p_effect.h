@@ -66,14 +66,14 @@ struct particle_t
 	float	fadestep;
 	float	alpha;
 	int		color;
-	WORD	tnext;
-	WORD	snext;
+	DWORD	tnext;
+	DWORD	snext;
 };
 
 extern particle_t *Particles;
-extern TArray<WORD>		ParticlesInSubsec;
+extern TArray<DWORD>	ParticlesInSubsec;
 
-const WORD NO_PARTICLE = 0xffff;
+const DWORD NO_PARTICLE = 0xffffffff;
 
 void P_ClearParticles ();
 void P_FindParticleSubsectors ();
@@ -6135,7 +6135,7 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 		for (i = 0; i < sector->e->XFloor.attached.Size(); i++)
 		{
 			sec = sector->e->XFloor.attached[i];
-			P_Recalculate3DFloors(sec);	// Must recalculate the 3d floor and light lists
+			P_Update3DFloors(sec);	// Must recalculate the 3d floor and light lists
 
 			// no thing checks for attached sectors because of heightsec
 			if (sec->heightsec == sector) continue;
@@ -6160,7 +6160,7 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			sec->CheckPortalPlane(!floorOrCeil);
 		}
 	}
-	P_Recalculate3DFloors(sector);			// Must recalculate the 3d floor and light lists
+	P_Update3DFloors(sector);			// Must recalculate the 3d floor and light lists
 
 	// [RH] Use different functions for the four different types of sector
 	// movement.
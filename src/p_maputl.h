@@ -7,6 +7,7 @@
 #include "m_bbox.h"
 
 extern int validcount;
+struct FPortalQueryContext;
 
 struct divline_t
 {
@@ -250,8 +251,8 @@ public:
 		int portalflags;
 	};
 
-	FMultiBlockLinesIterator(FPortalGroupArray &check, AActor *origin, double checkradius = -1);
-	FMultiBlockLinesIterator(FPortalGroupArray &check, double checkx, double checky, double checkz, double checkh, double checkradius, sector_t *newsec);
+	FMultiBlockLinesIterator(FPortalGroupArray &check, AActor *origin, double checkradius = -1, FPortalQueryContext *context = NULL);
+	FMultiBlockLinesIterator(FPortalGroupArray &check, double checkx, double checky, double checkz, double checkh, double checkradius, sector_t *newsec, FPortalQueryContext *context = NULL);
 
 	bool Next(CheckResult *item);
 	void Reset();
@@ -336,8 +337,8 @@ public:
 		int portalflags;
 	};
 
-	FMultiBlockThingsIterator(FPortalGroupArray &check, AActor *origin, double checkradius = -1, bool ignorerestricted = false);
-	FMultiBlockThingsIterator(FPortalGroupArray &check, double checkx, double checky, double checkz, double checkh, double checkradius, bool ignorerestricted, sector_t *newsec);
+	FMultiBlockThingsIterator(FPortalGroupArray &check, AActor *origin, double checkradius = -1, bool ignorerestricted = false, FPortalQueryContext *context = NULL);
+	FMultiBlockThingsIterator(FPortalGroupArray &check, double checkx, double checky, double checkz, double checkh, double checkradius, bool ignorerestricted, sector_t *newsec, FPortalQueryContext *context = NULL);
 	bool Next(CheckResult *item);
 	void Reset();
 	const FBoundingBox &Box() const
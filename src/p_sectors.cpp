@@ -695,14 +695,14 @@ double sector_t::FindLowestCeilingPoint (vertex_t **v) const
 void sector_t::SetColor(int r, int g, int b, int desat)
 {
 	PalEntry color = PalEntry (r,g,b);
-	ColorMap = GetSpecialLights (color, ColorMap->Fade, desat);
+	ColorMap = GetSpecialLights (color, ColorMap->Fade, desat, true);
 	P_RecalculateAttachedLights(this);
 }
 
 void sector_t::SetFade(int r, int g, int b)
 {
 	PalEntry fade = PalEntry (r,g,b);
-	ColorMap = GetSpecialLights (ColorMap->Color, fade, ColorMap->Desaturate);
+	ColorMap = GetSpecialLights (ColorMap->Color, fade, ColorMap->Desaturate, true);
 	P_RecalculateAttachedLights(this);
 }
 
@@ -1536,13 +1536,13 @@ void P_LoadSectors (MapData *map, FMissingTextureTracker &missingtex)
 		if (level.outsidefog != 0xff000000 && (ss->GetTexture(sector_t::ceiling) == skyflatnum || (ss->special&0xff) == Sector_Outside))
 		{
 			if (fogMap == NULL)
-				fogMap = GetSpecialLights (PalEntry (255,255,255), level.outsidefog, 0);
+				fogMap = GetSpecialLights (PalEntry (255,255,255), level.outsidefog, 0, true);
 			ss->ColorMap = fogMap;
 		}
 		else
 		{
 			if (normMap == NULL)
-				normMap = GetSpecialLights (PalEntry (255,255,255), level.fadeto, NormalLight.Desaturate);
+				normMap = GetSpecialLights (PalEntry (255,255,255), level.fadeto, NormalLight.Desaturate, true);
 			ss->ColorMap = normMap;
 		}
 
@@ -2541,7 +2541,7 @@ void P_ProcessSideTextures(bool checktranmap, side_t *sd, sector_t *sec, intmaps
 							colormap->Color != color ||
 							colormap->Fade != fog)
 						{
-							colormap = GetSpecialLights (color, fog, 0);
+							colormap = GetSpecialLights (color, fog, 0, true);
 						}
 						sectors[s].ColorMap = colormap;
 					}
@@ -3441,6 +3441,7 @@ void P_FreeLevelData ()
 {
 	interpolator.ClearInterpolations();	// [RH] Nothing to interpolate on a fresh level.
 	Renderer->CleanLevelData();
+	R_ClearPointNodes();
 	FPolyObj::ClearAllSubsectorLinks(); // can't be done as part of the polyobj deletion process.
 	SN_StopAllSequences ();
 	DThinker::DestroyAllThinkers ();
@@ -4011,6 +4012,7 @@ void P_SetupLevel (const char *lumpname, int position)
 	{
 		hasglnodes = P_CheckForGLNodes();
 	}
+	R_BuildPointNodes();
 
 	times[10].Clock();
 	P_LoadBlockMap (map);
@@ -179,6 +179,219 @@ void UDMFParserBase::Skip()
 	}
 }
 
+//===========================================================================
+//
+// Raw text helpers for the ParseKey fast path
+//
+//===========================================================================
+
+static inline bool UDMF_IsIdentStart(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool UDMF_IsIdentChar(char c)
+{
+	return UDMF_IsIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+static inline bool UDMF_IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Skips whitespace and comments the same way the scanner does. Returns NULL
+// for an unterminated block comment so that the scanner can deal with it.
+static const char *UDMF_SkipSpace(const char *p, const char *end, int &line)
+{
+	while (p < end)
+	{
+		unsigned char c = *p;
+		if (c == '\n')
+		{
+			line++;
+			p++;
+		}
+		else if (c <= ' ')
+		{
+			p++;
+		}
+		else if (c == '/' && p + 1 < end && p[1] == '/')
+		{
+			p += 2;
+			while (p < end && *p != '\n') p++;
+		}
+		else if (c == '/' && p + 1 < end && p[1] == '*')
+		{
+			p += 2;
+			for (;;)
+			{
+				if (p + 1 >= end) return NULL;
+				if (p[0] == '*' && p[1] == '/') break;
+				if (*p == '\n') line++;
+				p++;
+			}
+			p += 2;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return p;
+}
+
+//===========================================================================
+//
+// Parses a 'key = value' line directly from the script buffer.
+//
+// TEXTMAP lumps consist almost entirely of simple assignments, and pushing
+// every one of them through the generic scanner (key, '=', value and ';' as
+// separate tokens, each copied into the string buffer and converted again)
+// dominates the load time of large maps. This handles identifiers as keys
+// and decimal numbers, strings without escape sequences and true/false as
+// values. Anything else returns false without having consumed anything so
+// that the regular path can parse it and report errors as before.
+//
+//===========================================================================
+
+bool UDMFParserBase::ParseKeyFast(FName &key, bool checkblock, bool *isblock)
+{
+	FScanner::SavedPos pos = sc.GetRawPos();
+	const char *p = pos.SavedScriptPtr;
+	const char *end = sc.GetRawEnd();
+	int line = pos.SavedScriptLine;
+
+	if (p == NULL) return false;
+	p = UDMF_SkipSpace(p, end, line);
+	if (p == NULL || p >= end || !UDMF_IsIdentStart(*p)) return false;
+
+	const char *keystart = p;
+	while (p < end && UDMF_IsIdentChar(*p)) p++;
+	const char *keyend = p;
+
+	p = UDMF_SkipSpace(p, end, line);
+	if (p == NULL || p >= end) return false;
+
+	if (checkblock && *p == '{')
+	{
+		// Let the scanner consume the brace so that callers can still UnGet it.
+		key = FName(keystart, size_t(keyend - keystart), false);
+		pos.SavedScriptPtr = p;
+		pos.SavedScriptLine = line;
+		sc.RestorePos(pos);
+		sc.MustGetToken('{');
+		if (isblock) *isblock = true;
+		return true;
+	}
+	if (*p != '=') return false;
+	p = UDMF_SkipSpace(p + 1, end, line);
+	if (p == NULL || p >= end) return false;
+
+	int token;
+	int number = 0;
+	double fnumber = 0;
+	const char *strstart = NULL, *strend = NULL;
+
+	if (*p == '"')
+	{
+		strstart = ++p;
+		while (p < end && *p != '"')
+		{
+			if (*p == '\\') return false;
+			if (*p == '\n') line++;
+			p++;
+		}
+		if (p >= end) return false;
+		strend = p++;
+		token = TK_StringConst;
+	}
+	else if (UDMF_IsIdentStart(*p))
+	{
+		const char *word = p;
+		while (p < end && UDMF_IsIdentChar(*p)) p++;
+		if (p - word == 4 && !strnicmp(word, "true", 4)) token = TK_True;
+		else if (p - word == 5 && !strnicmp(word, "false", 5)) token = TK_False;
+		else return false;
+	}
+	else
+	{
+		bool neg = false;
+		if (*p == '+' || *p == '-')
+		{
+			neg = (*p == '-');
+			p = UDMF_SkipSpace(p + 1, end, line);
+			if (p == NULL || p >= end) return false;
+		}
+
+		// Accept the same shapes as the scanner's decimal and floating point
+		// constants. Octal, hex and suffixed integers go the regular way.
+		const char *num = p;
+		int intdigits = 0, fracdigits = 0;
+		bool isfloat = false;
+
+		while (p < end && UDMF_IsDigit(*p)) p++, intdigits++;
+		if (p < end && *p == '.')
+		{
+			isfloat = true;
+			p++;
+			while (p < end && UDMF_IsDigit(*p)) p++, fracdigits++;
+		}
+		if (intdigits + fracdigits == 0) return false;
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char *exp = p + 1;
+			if (exp < end && (*exp == '+' || *exp == '-')) exp++;
+			if (exp < end && UDMF_IsDigit(*exp))
+			{
+				isfloat = true;
+				p = exp;
+				while (p < end && UDMF_IsDigit(*p)) p++;
+			}
+		}
+
+		char *stopper;
+		if (isfloat)
+		{
+			fnumber = strtod(num, &stopper);
+			if (stopper != p) return false;
+			if (p < end && (*p == 'f' || *p == 'F')) p++;
+			token = TK_FloatConst;
+		}
+		else
+		{
+			if (intdigits > 1 && *num == '0') return false;
+			number = (int)strtol(num, &stopper, 10);
+			if (stopper != p) return false;
+			fnumber = number;
+			token = TK_IntConst;
+		}
+		if (neg)
+		{
+			number = -number;
+			fnumber = -fnumber;
+		}
+	}
+
+	p = UDMF_SkipSpace(p, end, line);
+	if (p == NULL || p >= end || *p != ';') return false;
+
+	key = FName(keystart, size_t(keyend - keystart), false);
+	if (checkblock && isblock) *isblock = false;
+	if (token == TK_StringConst)
+	{
+		parsedString = FString(strstart, strend - strstart);
+	}
+	sc.TokenType = token;
+	sc.Number = number;
+	sc.Float = fnumber;
+
+	pos.SavedScriptPtr = p + 1;
+	pos.SavedScriptLine = line;
+	sc.RestorePos(pos);
+	return true;
+}
+
 //===========================================================================
 //
 // Parses a 'key = value' line of the map
@@ -187,8 +400,15 @@ void UDMFParserBase::Skip()
 
 FName UDMFParserBase::ParseKey(bool checkblock, bool *isblock)
 {
+	FName key;
+
+	if (ParseKeyFast(key, checkblock, isblock))
+	{
+		return key;
+	}
+
 	sc.MustGetString();
-	FName key = sc.String;
+	key = sc.String;
 	if (checkblock)
 	{
 		if (sc.CheckToken('{'))
@@ -1681,13 +1901,13 @@ public:
 			if (level.outsidefog != 0xff000000 && (sec->GetTexture(sector_t::ceiling) == skyflatnum || (sec->special & 0xff) == Sector_Outside))
 			{
 				if (fogMap == NULL)
-					fogMap = GetSpecialLights(PalEntry(255, 255, 255), level.outsidefog, 0);
+					fogMap = GetSpecialLights(PalEntry(255, 255, 255), level.outsidefog, 0, true);
 				sec->ColorMap = fogMap;
 			}
 			else
 			{
 				if (normMap == NULL)
-					normMap = GetSpecialLights (PalEntry (255,255,255), level.fadeto, NormalLight.Desaturate);
+					normMap = GetSpecialLights (PalEntry (255,255,255), level.fadeto, NormalLight.Desaturate, true);
 				sec->ColorMap = normMap;
 			}
 		}
@@ -1703,7 +1923,7 @@ public:
 			}
 			if (desaturation == -1) desaturation = NormalLight.Desaturate;
 
-			sec->ColorMap = GetSpecialLights (lightcolor, fadecolor, desaturation);
+			sec->ColorMap = GetSpecialLights (lightcolor, fadecolor, desaturation, true);
 		}
 	}
 
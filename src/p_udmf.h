@@ -14,6 +14,7 @@ protected:
 
 	void Skip();
 	FName ParseKey(bool checkblock = false, bool *isblock = NULL);
+	bool ParseKeyFast(FName &key, bool checkblock, bool *isblock);
 	int CheckInt(const char *key);
 	double CheckFloat(const char *key);
 	DAngle CheckAngle(const char *key);
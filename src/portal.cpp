@@ -63,39 +63,15 @@ FPortalBlockmap PortalBlockmap;
 TArray<FLinePortal> linePortals;
 TArray<FLinePortal*> linkedPortals;	// only the linked portals, this is used to speed up looking for them in P_CollectConnectedGroups.
 
-TArray<FSectorPortal> sectorPortals;
-
-//============================================================================
-//
-// This is used to mark processed portals for some collection functions.
-//
-//============================================================================
-
-struct FPortalBits
-{
-	TArray<DWORD> data;
-
-	void setSize(int num)
-	{
-		data.Resize((num + 31) / 32);
-		clear();
-	}
+// For each portal group, the linked portals whose origin group has a displacement from it.
+// The entries for group n are GroupLinks[GroupLinkStart[n]] to GroupLinks[GroupLinkStart[n+1]-1].
+static TArray<unsigned> GroupLinkStart;
+static TArray<FLinePortal*> GroupLinks;
 
-	void clear()
-	{
-		memset(&data[0], 0, data.Size()*sizeof(DWORD));
-	}
+// The scratch space used by callers that do not provide their own.
+static FPortalQueryContext DefaultQueryContext;
 
-	void setBit(int group)
-	{
-		data[group >> 5] |= (1 << (group & 31));
-	}
-
-	int getBit(int group)
-	{
-		return data[group >> 5] & (1 << (group & 31));
-	}
-};
+TArray<FSectorPortal> sectorPortals;
 
 //============================================================================
 //
@@ -403,6 +379,38 @@ void P_CollectLinkedPortals()
 			linkedPortals.Push(port);
 		}
 	}
+	P_BuildGroupLinkTable();
+}
+
+//============================================================================
+//
+// Precompute which linked portals can be reached from each portal group
+// so that P_CollectConnectedGroups does not have to check all of them
+// against the displacement table for every query.
+//
+//============================================================================
+
+void P_BuildGroupLinkTable()
+{
+	int numgroups = Displacements.size;
+
+	GroupLinkStart.Resize(numgroups + 1);
+	GroupLinks.Clear();
+	for (int group = 0; group < numgroups; group++)
+	{
+		GroupLinkStart[group] = GroupLinks.Size();
+		if (numgroups == 1) continue;
+		for (unsigned i = 0; i < linkedPortals.Size(); i++)
+		{
+			int othergroup = linkedPortals[i]->mOrigin->frontsector->PortalGroup;
+			if (othergroup < numgroups && Displacements(group, othergroup).isSet)
+			{
+				GroupLinks.Push(linkedPortals[i]);
+			}
+		}
+	}
+	GroupLinkStart[numgroups] = GroupLinks.Size();
+	GroupLinks.ShrinkToFit();
 }
 
 //============================================================================
@@ -491,6 +499,8 @@ void P_ClearPortals()
 	Displacements.Create(1);
 	linePortals.Clear();
 	linkedPortals.Clear();
+	GroupLinkStart.Clear();
+	GroupLinks.Clear();
 	sectorPortals.Resize(2);
 	// The first entry must always be the default skybox. This is what every sector gets by default.
 	memset(&sectorPortals[0], 0, sizeof(sectorPortals[0]));
@@ -1078,6 +1088,7 @@ void P_CreateLinkedPortals()
 		}
 	}
 	bogus |= ConnectGroups();
+	P_BuildGroupLinkTable();
 	if (bogus)
 	{
 		// todo: disable all portals whose offsets do not match the associated groups
@@ -1155,13 +1166,14 @@ void P_CreateLinkedPortals()
 //
 //============================================================================
 
-bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double upperz, double checkradius, FPortalGroupArray &out)
+bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double upperz, double checkradius, FPortalGroupArray &out, FPortalQueryContext *context)
 {
-	// Keep this temporary work stuff static. This function can never be called recursively
-	// and this would have to be reallocated for each call otherwise.
-	static FPortalBits processMask;
-	static TArray<FLinePortal*> foundPortals;
-	static TArray<int> groupsToCheck;
+	// All temporary work space lives in the query context so that it only needs to be
+	// allocated once and so that queries using different contexts do not interfere.
+	FPortalQueryContext &ctx = context != NULL ? *context : DefaultQueryContext;
+	FPortalBits &processMask = ctx.processMask;
+	TArray<FLinePortal*> &foundPortals = ctx.foundPortals;
+	TArray<int> &groupsToCheck = ctx.groupsToCheck;
 
 	bool retval = false;
 	out.inited = true;
@@ -1173,7 +1185,7 @@ bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double u
 		return false;
 	}
 
-	if (linkedPortals.Size() != 0)
+	if (linkedPortals.Size() != 0 && (unsigned)startgroup + 1 < GroupLinkStart.Size())
 	{
 		processMask.clear();
 		foundPortals.Clear();
@@ -1182,17 +1194,16 @@ bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double u
 		processMask.setBit(thisgroup);
 		//out.Add(thisgroup);
 
-		for (unsigned i = 0; i < linkedPortals.Size(); i++)
+		for (unsigned i = GroupLinkStart[thisgroup]; i < GroupLinkStart[thisgroup + 1]; i++)
 		{
-			line_t *ld = linkedPortals[i]->mOrigin;
-			int othergroup = ld->frontsector->PortalGroup;
-			FDisplacement &disp = Displacements(thisgroup, othergroup);
-			if (!disp.isSet) continue;	// no connection.
+			FLinePortal *port = GroupLinks[i];
+			line_t *ld = port->mOrigin;
+			FDisplacement &disp = Displacements(thisgroup, ld->frontsector->PortalGroup);
 
 			FBoundingBox box(position.X + disp.pos.X, position.Y + disp.pos.Y, checkradius);
 
-			if (!box.inRange(ld) || box.BoxOnLineSide(linkedPortals[i]->mOrigin) != -1) continue;	// not touched
-			foundPortals.Push(linkedPortals[i]);
+			if (!box.inRange(ld) || box.BoxOnLineSide(ld) != -1) continue;	// not touched
+			foundPortals.Push(port);
 		}
 		bool foundone = true;
 		while (foundone)
@@ -239,6 +239,57 @@ struct FSectorPortal
 
 extern TArray<FSectorPortal> sectorPortals;
 
+//============================================================================
+//
+// This is used to mark processed portals for some collection functions.
+//
+//============================================================================
+
+struct FPortalBits
+{
+	TArray<DWORD> data;
+
+	void setSize(int num)
+	{
+		data.Resize((num + 31) / 32);
+		clear();
+	}
+
+	void clear()
+	{
+		memset(&data[0], 0, data.Size()*sizeof(DWORD));
+	}
+
+	void setBit(int group)
+	{
+		data[group >> 5] |= (1 << (group & 31));
+	}
+
+	int getBit(int group)
+	{
+		return data[group >> 5] & (1 << (group & 31));
+	}
+};
+
+//============================================================================
+//
+// Scratch space for P_CollectConnectedGroups.
+//
+// The arrays only grow, so a context that is kept around makes repeated
+// queries allocation free. Code that runs portal queries outside the main
+// playsim loop has to use its own context. The PGA_Full3d collection also
+// walks the blockmap, which depends on the global validcount, so that mode
+// is still restricted to the main thread.
+//
+//============================================================================
+
+struct FPortalQueryContext
+{
+	FPortalBits processMask;
+	TArray<FLinePortal*> foundPortals;
+	TArray<int> groupsToCheck;
+};
+
 //============================================================================
 //
 // Functions
@@ -250,8 +301,9 @@ void P_SpawnLinePortal(line_t* line);
 void P_FinalizePortals();
 bool P_ChangePortal(line_t *ln, int thisid, int destid);
 void P_CreateLinkedPortals();
-bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double upperz, double checkradius, FPortalGroupArray &out);
+bool P_CollectConnectedGroups(int startgroup, const DVector3 &position, double upperz, double checkradius, FPortalGroupArray &out, FPortalQueryContext *context = NULL);
 void P_CollectLinkedPortals();
+void P_BuildGroupLinkTable();
 inline int P_NumPortalGroups()
 {
 	return Displacements.size;
@@ -12,10 +12,18 @@
 #include "v_palette.h"
 #include "sdlvideo.h"
 #include "r_swrenderer.h"
+#include "r_draw_rgba.h"
+#include "profiler.h"
+#include "sbar.h"
 #include "version.h"
 
 #include <SDL.h>
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
 #ifdef __APPLE__
 #include <OpenGL/OpenGL.h>
 #endif // __APPLE__
@@ -73,13 +81,71 @@ private:
 	bool NeedGammaUpdate;
 	bool NotPaletted;
 
+	// State of the pipelined blit: the frame handed to BlitThread is
+	// converted into the locked target while the next frame is played
+	// and rendered, and presented at the start of the next Update.
+	BYTE *BackBuffer;
+	std::thread BlitThread;
+	std::mutex BlitMutex;
+	std::condition_variable BlitCondition;
+	std::unique_ptr<DrawerCommand> BlitCommand;
+	bool BlitBusy;
+	bool BlitShutdown;
+	bool BlitLocked;
+
 	void UpdateColors ();
+	void ApplyColorChanges ();
 	void ResetSDLRenderer ();
+	bool LockTarget (void *&pixels, int &pitch);
+	void UnlockTarget ();
+	void Present ();
+	void StartBlit ();
+	bool FlushBlit ();
 
 	SDLFB () {}
 };
 IMPLEMENT_CLASS(SDLFB)
 
+// Converts a finished paletted frame to the pixel format of the video
+// output, a row at a time on each drawer thread.
+class PfxConvertCommand : public DrawerCommand
+{
+	const BYTE *src;
+	int srcpitch;
+	BYTE *dest;
+	int destpitch;
+	int width;
+	int height;
+	bool convert;
+
+public:
+	PfxConvertCommand(const BYTE *src, int srcpitch, void *dest, int destpitch, int width, int height, bool convert)
+		: src(src), srcpitch(srcpitch), dest((BYTE*)dest), destpitch(destpitch), width(width), height(height), convert(convert)
+	{
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		int y = thread->skipped_by_thread(0);
+		int count = thread->count_for_thread(0, height);
+		while (count > 0)
+		{
+			if (convert)
+			{
+				GPfx.Convert ((BYTE *)src + y*srcpitch, srcpitch,
+					dest + y*destpitch, destpitch, width, 1,
+					FRACUNIT, FRACUNIT, 0, 0);
+			}
+			else
+			{
+				memcpy (dest + y*destpitch, src + y*srcpitch, width);
+			}
+			y += thread->num_cores;
+			count--;
+		}
+	}
+};
+
 struct MiniModeInfo
 {
 	WORD Width, Height;
@@ -107,6 +173,16 @@ CVAR (Int, vid_displaybits, 32, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 CVAR (Bool, vid_forcesurface, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
+// Overlaps the conversion of each frame with the next tic, at the cost of
+// presenting it one frame later.
+CUSTOM_CVAR (Bool, vid_pipelineblit, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG|CVAR_NOINITCALL)
+{
+	// The number of pages changes, so everything drawn only on
+	// demand needs to be drawn again.
+	V_SetBorderNeedRefresh();
+	ST_SetNeedRefresh();
+}
+
 CUSTOM_CVAR (Float, rgamma, 1.f, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 {
 	if (screen != NULL)
@@ -361,6 +437,10 @@ SDLFB::SDLFB (int width, int height, bool bgra, bool fullscreen, SDL_Window *old
 	UpdatePending = false;
 	NotPaletted = false;
 	FlashAmount = 0;
+	BackBuffer = NULL;
+	BlitBusy = false;
+	BlitShutdown = false;
+	BlitLocked = false;
 
 	if (oldwin)
 	{
@@ -404,6 +484,20 @@ SDLFB::SDLFB (int width, int height, bool bgra, bool fullscreen, SDL_Window *old
 
 SDLFB::~SDLFB ()
 {
+	FlushBlit ();
+	if (BlitThread.joinable())
+	{
+		std::unique_lock<std::mutex> lock(BlitMutex);
+		BlitShutdown = true;
+		lock.unlock();
+		BlitCondition.notify_all();
+		BlitThread.join();
+	}
+	if (BackBuffer != NULL)
+	{
+		delete[] BackBuffer;
+	}
+
 	if (Renderer)
 	{
 		if (Texture)
@@ -424,7 +518,7 @@ bool SDLFB::IsValid ()
 
 int SDLFB::GetPageCount ()
 {
-	return 1;
+	return vid_pipelineblit ? 2 : 1;
 }
 
 bool SDLFB::Lock (bool buffered)
@@ -475,87 +569,206 @@ void SDLFB::Update ()
 	LockCount = 0;
 	UpdatePending = false;
 
+	FProfileScope profile("Blit");
 	BlitCycles.Reset();
 	SDLFlipCycles.Reset();
 	BlitCycles.Clock();
 
+	// Show the frame the blit thread converted while this one was made.
+	if (FlushBlit ())
+	{
+		Present ();
+	}
+
+	if (vid_pipelineblit)
+	{
+		// Nothing reads the gamma tables or the palette now, so they
+		// can be changed before the next conversion starts.
+		ApplyColorChanges ();
+		StartBlit ();
+		BlitCycles.Unclock();
+		return;
+	}
+
 	void *pixels;
 	int pitch;
+	if (!LockTarget (pixels, pitch))
+		return;
+
+	if (Bgra)
+	{
+		CopyWithGammaBgra(pixels, pitch, GammaTable[0], GammaTable[1], GammaTable[2], Flash, FlashAmount);
+	}
+	else
+	{
+		DrawerCommandQueue::Begin();
+		DrawerCommandQueue::QueueCommand<PfxConvertCommand>(MemBuffer, Pitch, pixels, pitch, Width, Height, NotPaletted);
+		DrawerCommandQueue::End();
+	}
+
+	UnlockTarget ();
+	Present ();
+
+	BlitCycles.Unclock();
+
+	ApplyColorChanges ();
+}
+
+void SDLFB::ApplyColorChanges ()
+{
+	if (NeedGammaUpdate)
+	{
+		bool Windowed = false;
+		NeedGammaUpdate = false;
+		CalcGamma ((Windowed || rgamma == 0.f) ? Gamma : (Gamma * rgamma), GammaTable[0]);
+		CalcGamma ((Windowed || ggamma == 0.f) ? Gamma : (Gamma * ggamma), GammaTable[1]);
+		CalcGamma ((Windowed || bgamma == 0.f) ? Gamma : (Gamma * bgamma), GammaTable[2]);
+		NeedPalUpdate = true;
+	}
+	
+	if (NeedPalUpdate)
+	{
+		NeedPalUpdate = false;
+		UpdateColors ();
+	}
+}
+
+bool SDLFB::LockTarget (void *&pixels, int &pitch)
+{
 	if (UsingRenderer)
 	{
 		if (SDL_LockTexture (Texture, NULL, &pixels, &pitch))
-			return;
+			return false;
 	}
 	else
 	{
 		if (SDL_LockSurface (Surface))
-			return;
+			return false;
 
 		pixels = Surface->pixels;
 		pitch = Surface->pitch;
 	}
+	return true;
+}
 
-	if (Bgra)
-	{
-		CopyWithGammaBgra(pixels, pitch, GammaTable[0], GammaTable[1], GammaTable[2], Flash, FlashAmount);
-	}
-	else if (NotPaletted)
+void SDLFB::UnlockTarget ()
+{
+	if (UsingRenderer)
 	{
-		GPfx.Convert (MemBuffer, Pitch,
-			pixels, pitch, Width, Height,
-			FRACUNIT, FRACUNIT, 0, 0);
+		SDL_UnlockTexture (Texture);
 	}
 	else
 	{
-		if (pitch == Pitch)
-		{
-			memcpy (pixels, MemBuffer, Width*Height);
-		}
-		else
-		{
-			for (int y = 0; y < Height; ++y)
-			{
-				memcpy ((BYTE *)pixels+y*pitch, MemBuffer+y*Pitch, Width);
-			}
-		}
+		SDL_UnlockSurface (Surface);
 	}
+}
 
+void SDLFB::Present ()
+{
+	SDLFlipCycles.Clock();
 	if (UsingRenderer)
 	{
-		SDL_UnlockTexture (Texture);
-
-		SDLFlipCycles.Clock();
 		SDL_RenderClear(Renderer);
 		SDL_RenderCopy(Renderer, Texture, NULL, NULL);
 		SDL_RenderPresent(Renderer);
-		SDLFlipCycles.Unclock();
 	}
 	else
 	{
-		SDL_UnlockSurface (Surface);
-
-		SDLFlipCycles.Clock();
 		SDL_UpdateWindowSurface (Screen);
-		SDLFlipCycles.Unclock();
 	}
+	SDLFlipCycles.Unclock();
+}
 
-	BlitCycles.Unclock();
+//==========================================================================
+//
+// SDLFB :: StartBlit
+//
+// Hands the finished frame to the blit thread and gives the renderer the
+// other buffer to draw the next one into. The target stays locked until
+// FlushBlit.
+//
+//==========================================================================
 
-	if (NeedGammaUpdate)
+void SDLFB::StartBlit ()
+{
+	void *pixels;
+	int pitch;
+	if (!LockTarget (pixels, pitch))
+		return;
+
+	if (BackBuffer == NULL)
 	{
-		bool Windowed = false;
-		NeedGammaUpdate = false;
-		CalcGamma ((Windowed || rgamma == 0.f) ? Gamma : (Gamma * rgamma), GammaTable[0]);
-		CalcGamma ((Windowed || ggamma == 0.f) ? Gamma : (Gamma * ggamma), GammaTable[1]);
-		CalcGamma ((Windowed || bgamma == 0.f) ? Gamma : (Gamma * bgamma), GammaTable[2]);
-		NeedPalUpdate = true;
+		size_t size = Pitch * Height * (Bgra ? 4 : 1);
+		BackBuffer = new BYTE[size];
+		memset (BackBuffer, 0, size);
 	}
-	
-	if (NeedPalUpdate)
+	std::swap (MemBuffer, BackBuffer);
+
+	if (Bgra)
 	{
-		NeedPalUpdate = false;
-		UpdateColors ();
+		BlitCommand.reset(new CopyWithGammaBgraCommand(BackBuffer, Pitch, pixels, pitch, Width, Height, GammaTable[0], GammaTable[1], GammaTable[2], Flash, FlashAmount));
+	}
+	else
+	{
+		BlitCommand.reset(new PfxConvertCommand(BackBuffer, Pitch, pixels, pitch, Width, Height, NotPaletted));
 	}
+
+	if (!BlitThread.joinable())
+	{
+		BlitThread = std::thread([=]()
+		{
+			// A single worker covering every row of the frame.
+			std::unique_ptr<DrawerThread> thread(new DrawerThread);
+			Prof_SetThreadName("Blit");
+			std::unique_lock<std::mutex> lock(BlitMutex);
+			while (true)
+			{
+				BlitCondition.wait(lock, [&]() { return BlitBusy || BlitShutdown; });
+				if (BlitShutdown)
+					break;
+
+				lock.unlock();
+				{
+					FProfileScope profile("Blit conversion");
+					BlitCommand->Execute(thread.get());
+				}
+				lock.lock();
+
+				BlitBusy = false;
+				BlitCondition.notify_all();
+			}
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(BlitMutex);
+	BlitBusy = true;
+	BlitLocked = true;
+	lock.unlock();
+	BlitCondition.notify_all();
+}
+
+//==========================================================================
+//
+// SDLFB :: FlushBlit
+//
+// Waits for the blit thread and unlocks the target it was converting
+// into. Returns true if there is a frame waiting to be presented.
+//
+//==========================================================================
+
+bool SDLFB::FlushBlit ()
+{
+	if (!BlitLocked)
+		return false;
+
+	std::unique_lock<std::mutex> lock(BlitMutex);
+	BlitCondition.wait(lock, [&]() { return !BlitBusy; });
+	BlitLocked = false;
+	lock.unlock();
+
+	BlitCommand.reset();
+	UnlockTarget ();
+	return true;
 }
 
 void SDLFB::UpdateColors ()
@@ -644,6 +857,8 @@ void SDLFB::SetFullscreen (bool fullscreen)
 	if (IsFullscreen() == fullscreen)
 		return;
 
+	FlushBlit ();
+
 	SDL_SetWindowFullscreen (Screen, fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
 	if (!fullscreen)
 	{
@@ -661,6 +876,7 @@ bool SDLFB::IsFullscreen ()
 
 void SDLFB::ResetSDLRenderer ()
 {
+	FlushBlit ();
 	if (Renderer)
 	{
 		if (Texture)
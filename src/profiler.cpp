@@ -0,0 +1,235 @@
+/*
+** profiler.cpp
+** Scoped timeline events, exported as Chrome trace event JSON
+**
+** Every thread that records events gets its own ring buffer. Only the
+** owning thread writes to it, so recording needs no locks; the mutex is
+** only taken the first time a thread records something or names itself.
+** When a buffer is full the oldest events get overwritten.
+**
+** Threads that are inside Prof_AddEvent are counted, so that starting and
+** dumping can wait until nobody is writing to the buffers any more.
+**
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+
+#include "doomtype.h"
+#include "templates.h"
+#include "c_dispatch.h"
+#include "zstring.h"
+#include "profiler.h"
+#include "r_draw_rgba.h"
+
+std::atomic<bool> ProfilerActive;
+
+enum
+{
+	PROF_EVENTS_PER_THREAD = 1 << 16
+};
+
+struct FProfileEvent
+{
+	const char *Name;
+	uint64_t Start, End;
+};
+
+struct FProfileThread
+{
+	FString Name;
+	int Id;
+	std::atomic<unsigned> Head;		// Total number of events written
+	FProfileEvent Events[PROF_EVENTS_PER_THREAD];
+};
+
+static std::mutex ProfileMutex;
+static std::vector<std::unique_ptr<FProfileThread>> ProfileThreads;
+static thread_local FProfileThread *CurrentThread;
+static thread_local char CurrentThreadName[64];	// until the thread has a buffer
+static uint64_t ProfileStart;
+static std::atomic<int> ProfileWriters;
+
+//==========================================================================
+//
+// Prof_Now
+//
+// Returns the current time in nanoseconds.
+//
+//==========================================================================
+
+uint64_t Prof_Now()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//==========================================================================
+//
+// GetThread
+//
+//==========================================================================
+
+static FProfileThread *GetThread()
+{
+	if (CurrentThread == nullptr)
+	{
+		std::unique_lock<std::mutex> lock(ProfileMutex);
+		FProfileThread *thread = new FProfileThread;
+		thread->Id = (int)ProfileThreads.size() + 1;
+		if (CurrentThreadName[0] != 0) thread->Name = CurrentThreadName;
+		else thread->Name.Format("Thread %d", thread->Id);
+		thread->Head = 0;
+		ProfileThreads.push_back(std::unique_ptr<FProfileThread>(thread));
+		CurrentThread = thread;
+	}
+	return CurrentThread;
+}
+
+//==========================================================================
+//
+// Prof_AddEvent
+//
+//==========================================================================
+
+void Prof_AddEvent(const char *name, uint64_t start, uint64_t end)
+{
+	// Recording may have been stopped since the scope began. Checking again
+	// after registering as a writer means Prof_Stop either sees this thread
+	// or this thread sees the profiler stopped.
+	ProfileWriters++;
+	if (ProfilerActive)
+	{
+		FProfileThread *thread = GetThread();
+		unsigned head = thread->Head.load(std::memory_order_relaxed);
+		FProfileEvent &event = thread->Events[head % PROF_EVENTS_PER_THREAD];
+		event.Name = name;
+		event.Start = start;
+		event.End = end;
+		thread->Head.store(head + 1, std::memory_order_release);
+	}
+	ProfileWriters--;
+}
+
+//==========================================================================
+//
+// Prof_Stop
+//
+// Stops recording and waits until no thread writes to its buffer anymore.
+// Drawer threads are idle once their queue is finished. Other threads,
+// like the blit thread, are waited for through the writer count.
+//
+//==========================================================================
+
+static void Prof_Stop()
+{
+	ProfilerActive = false;
+	DrawerCommandQueue::WaitForWorkers();
+	while (ProfileWriters != 0)
+	{
+		std::this_thread::yield();
+	}
+}
+
+//==========================================================================
+//
+// Prof_SetThreadName
+//
+//==========================================================================
+
+void Prof_SetThreadName(const char *name)
+{
+	// Don't allocate a buffer for threads that never record anything.
+	if (CurrentThread == nullptr)
+	{
+		strncpy(CurrentThreadName, name, countof(CurrentThreadName) - 1);
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(ProfileMutex);
+		CurrentThread->Name = name;
+	}
+}
+
+//==========================================================================
+//
+// CCMD profilestart
+//
+// Throws away everything recorded so far and starts recording.
+//
+//==========================================================================
+
+CCMD(profilestart)
+{
+	Prof_Stop();
+	{
+		std::unique_lock<std::mutex> lock(ProfileMutex);
+		for (auto &thread : ProfileThreads)
+		{
+			thread->Head = 0;
+		}
+	}
+	ProfileStart = Prof_Now();
+	ProfilerActive = true;
+	Printf("Recording timeline. Use profiledump to save it.\n");
+}
+
+//==========================================================================
+//
+// CCMD profiledump
+//
+// Stops recording and writes the events in Chrome's trace event format.
+//
+//==========================================================================
+
+CCMD(profiledump)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: profiledump <filename>\n");
+		return;
+	}
+	Prof_Stop();
+
+	FILE *file = fopen(argv[1], "w");
+	if (file == nullptr)
+	{
+		Printf("Could not open %s\n", argv[1]);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(ProfileMutex);
+	unsigned total = 0;
+	bool first = true;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (auto &thread : ProfileThreads)
+	{
+		FString name = thread->Name;
+		name.Substitute("\\", "\\\\");
+		name.Substitute("\"", "\\\"");
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			first ? "" : ",\n", thread->Id, name.GetChars());
+		first = false;
+
+		unsigned head = thread->Head.load(std::memory_order_acquire);
+		unsigned count = MIN<unsigned>(head, PROF_EVENTS_PER_THREAD);
+		for (unsigned i = head - count; i != head; i++)
+		{
+			const FProfileEvent &event = thread->Events[i % PROF_EVENTS_PER_THREAD];
+			if (event.Start < ProfileStart) continue;
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				event.Name, thread->Id, (event.Start - ProfileStart) / 1000.0, (event.End - event.Start) / 1000.0);
+			total++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	Printf("%u events from %u threads written to %s\n", total, (unsigned)ProfileThreads.size(), argv[1]);
+}
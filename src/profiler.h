@@ -0,0 +1,58 @@
+/*
+** profiler.h
+** Scoped timeline events, exported as Chrome trace event JSON
+**
+** Unlike the cycle_t counters in stats.h, which only show a running total,
+** this records when each stage started and ended on which thread, so stalls
+** and uneven work distribution between the drawer threads become visible.
+**
+** 'profilestart' starts recording, 'profiledump <file>' stops it and writes
+** the events to a file that can be loaded in chrome://tracing.
+**
+*/
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdint.h>
+#include <atomic>
+
+extern std::atomic<bool> ProfilerActive;
+
+uint64_t Prof_Now();
+void Prof_AddEvent(const char *name, uint64_t start, uint64_t end);
+
+// Names the calling thread in the exported timeline.
+void Prof_SetThreadName(const char *name);
+
+//==========================================================================
+//
+// Records the time from its construction to its destruction as one event.
+// The name must be a string literal or otherwise stay valid until the
+// events have been dumped.
+//
+//==========================================================================
+
+class FProfileScope
+{
+public:
+	FProfileScope(const char *name)
+	{
+		Name = ProfilerActive.load(std::memory_order_relaxed) ? name : nullptr;
+		if (Name != nullptr) Start = Prof_Now();
+	}
+
+	~FProfileScope()
+	{
+		if (Name != nullptr) Prof_AddEvent(Name, Start, Prof_Now());
+	}
+
+private:
+	FProfileScope(const FProfileScope &) = delete;
+	FProfileScope &operator=(const FProfileScope &) = delete;
+
+	const char *Name;
+	uint64_t Start;
+};
+
+#endif
@@ -35,14 +35,25 @@ int height_max = -1;
 TArray<HeightStack> toplist;
 ClipStack *clip_top = NULL;
 ClipStack *clip_cur = NULL;
+HeightLevel *height_free = NULL;	// levels released by R_3D_DeleteHeights, for reuse
+
+static HeightLevel *R_3D_NewHeight()
+{
+	HeightLevel *level = height_free;
+	if (level != NULL) height_free = level->next;
+	else level = (HeightLevel*)M_Malloc(sizeof(HeightLevel));
+	return level;
+}
 
 void R_3D_DeleteHeights()
 {
+	// The list is rebuilt for every subsector with 3D floors, so keep the nodes around.
 	height_cur = height_top;
 	while(height_cur) {
 		height_top = height_cur;
 		height_cur = height_cur->next;
-		M_Free(height_top);
+		height_top->next = height_free;
+		height_free = height_top;
 	}
 	height_max = -1;
 	height_top = height_cur = NULL;
@@ -64,7 +75,7 @@ void R_3D_AddHeight(secplane_t *add, sector_t *sec)
 		while(near && near->height < height) near = near->next;
 		if(near) {
 			if(near->height == height) return;
-			curr = (HeightLevel*)M_Malloc(sizeof(HeightLevel));
+			curr = R_3D_NewHeight();
 			curr->height = height;
 			curr->prev = near->prev;
 			curr->next = near;
@@ -72,7 +83,7 @@ void R_3D_AddHeight(secplane_t *add, sector_t *sec)
 			else height_top = curr;
 			near->prev = curr;
 		} else {
-			curr = (HeightLevel*)M_Malloc(sizeof(HeightLevel));
+			curr = R_3D_NewHeight();
 			curr->height = height;
 			curr->prev = height_cur;
 			curr->next = NULL;
@@ -80,7 +91,7 @@ void R_3D_AddHeight(secplane_t *add, sector_t *sec)
 			height_cur = curr;
 		}
 	} else {
-		height_top = height_cur = (HeightLevel*)M_Malloc(sizeof(HeightLevel));
+		height_top = height_cur = R_3D_NewHeight();
 		height_top->height = height;
 		height_top->prev = NULL;
 		height_top->next = NULL;
@@ -105,7 +105,29 @@ static BYTE		FakeSide;
 
 int WindowLeft, WindowRight;
 WORD MirrorFlags;
-TArray<PortalDrawseg> WallPortals(1000);	// note: this array needs to go away as reallocation can cause crashes.
+TArray<PortalDrawseg *> WallPortals(1000);
+static TDeletingArray<PortalDrawseg *> PortalDrawsegs;	// owns the entries of WallPortals
+
+//==========================================================================
+//
+// R_NewPortalDrawseg
+//
+// Adds a portal to WallPortals. The drawsegs are allocated once and reused
+// every frame, so pointers to them stay valid while more portals get added,
+// and their clip arrays keep their memory.
+//
+//==========================================================================
+
+PortalDrawseg *R_NewPortalDrawseg ()
+{
+	unsigned int index = WallPortals.Size();
+	if (index == PortalDrawsegs.Size())
+	{
+		PortalDrawsegs.Push(new PortalDrawseg);
+	}
+	WallPortals.Push(PortalDrawsegs[index]);
+	return PortalDrawsegs[index];
+}
 
 
 subsector_t *InSubsector;
@@ -1022,7 +1044,7 @@ extern "C" const int checkcoord[12][4] =
 };
 
 
-static bool R_CheckBBox (float *bspcoord)	// killough 1/28/98: static
+static bool R_CheckBBox (const float *bspcoord)	// killough 1/28/98: static
 {
 	int 				boxx;
 	int 				boxy;
@@ -1443,7 +1465,7 @@ void R_Subsector (subsector_t *sub)
 	if ((unsigned int)(sub - subsectors) < (unsigned int)numsubsectors)
 	{ // Only do it for the main BSP.
 		int shade = LIGHT2SHADE((floorlightlevel + ceilinglightlevel)/2 + r_actualextralight);
-		for (WORD i = ParticlesInSubsec[(unsigned int)(sub-subsectors)]; i != NO_PARTICLE; i = Particles[i].snext)
+		for (DWORD i = ParticlesInSubsec[(unsigned int)(sub-subsectors)]; i != NO_PARTICLE; i = Particles[i].snext)
 		{
 			R_ProjectParticle (Particles + i, subsectors[sub-subsectors].sector, shade, FakeSide);
 		}
@@ -1536,3 +1558,58 @@ void R_RenderBSPNode (void *node)
 	}
 	R_Subsector ((subsector_t *)((BYTE *)node - 1));
 }
+
+//==========================================================================
+//
+// R_RenderFlatBSPNode
+//
+// Same as R_RenderBSPNode, but walks the flattened copy of the level's
+// BSP. The partition lines and child links of several nodes share a cache
+// line there, and the bounding boxes are only fetched for the back side.
+//
+//==========================================================================
+
+static void R_RenderFlatBSPNode (const FPointNode *pn, const FPointNodeBox *boxes, DWORD index, fixed_t viewx, fixed_t viewy)
+{
+	while (!(index & POINTNODE_SUBSECTOR))
+	{
+		const FPointNode &bsp = pn[index];
+
+		// Decide which side the view point is on.
+		int side = DMulScale32 (viewy - bsp.y, bsp.dx, bsp.x - viewx, bsp.dy) > 0;
+
+		// Recursively divide front space (toward the viewer).
+		R_RenderFlatBSPNode (pn, boxes, bsp.children[side], viewx, viewy);
+
+		// Possibly divide back space (away from the viewer).
+		side ^= 1;
+		if (!R_CheckBBox (boxes[index].bbox[side]))
+			return;
+
+		index = bsp.children[side];
+	}
+	R_Subsector (&subsectors[index & ~POINTNODE_SUBSECTOR]);
+}
+
+//==========================================================================
+//
+// R_RenderBSP
+//
+// Renders the level's BSP from the root.
+//
+//==========================================================================
+
+void R_RenderBSP ()
+{
+	const FPointNodeBox *boxes;
+	const FPointNode *pn = R_GetPointNodes (&boxes);
+
+	if (pn != NULL)
+	{
+		R_RenderFlatBSPNode (pn, boxes, 0, FLOAT2FIXED(ViewPos.X), FLOAT2FIXED(ViewPos.Y));
+	}
+	else
+	{
+		R_RenderBSPNode (nodes + numnodes - 1);
+	}
+}
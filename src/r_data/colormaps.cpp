@@ -53,6 +53,10 @@
 #include "templates.h"
 #include "r_utility.h"
 #include "r_renderer.h"
+#include "r_state.h"
+#include "r_draw_rgba.h"
+#include "p_3dfloors.h"
+#include "stats.h"
 
 static bool R_CheckForFixedLights(const BYTE *colormaps);
 
@@ -185,19 +189,94 @@ int AddSpecialColormap(float r1, float g1, float b1, float r2, float g2, float b
 //
 //==========================================================================
 
-FDynamicColormap *GetSpecialLights (PalEntry color, PalEntry fade, int desaturate)
+// Colormaps created by GetSpecialLights are indexed by their color, fade
+// and desaturation. NormalLight is not, because those can change for it.
+struct FColormapKey
+{
+	DWORD Color;
+	DWORD Fade;
+	int Desaturate;
+
+	bool operator!= (const FColormapKey &other) const
+	{
+		return Color != other.Color || Fade != other.Fade || Desaturate != other.Desaturate;
+	}
+};
+
+template<> struct THashTraits<FColormapKey>
+{
+	hash_t Hash(const FColormapKey &key)
+	{
+		hash_t hash = key.Color * 0x9E3779B1u;
+		hash ^= (key.Fade * 0x85EBCA6Bu) + (hash >> 15);
+		hash ^= key.Desaturate * 0xC2B2AE35u;
+		return hash ^ (hash >> 16);
+	}
+	int Compare(const FColormapKey &left, const FColormapKey &right) { return left != right; }
+};
+
+static TMap<FColormapKey, FDynamicColormap *> SpecialLightsMap;
+static TArray<FDynamicColormap *> PendingLights;
+static int NumSpecialLights;
+static int CollectThreshold = 256;
+static int ColormapCollection = 1;
+static int NumBuiltLights;
+static int NumCollectedLights;
+static cycle_t ColormapBuildCycles;
+
+// Builds some of the light levels of a colormap on each drawer thread.
+class BuildLightsCommand : public DrawerCommand
+{
+	FDynamicColormap *colormap;
+	PalEntry basecolors[256];
+
+public:
+	BuildLightsCommand(FDynamicColormap *colormap) : colormap(colormap)
+	{
+		colormap->GetBaseColors (basecolors);
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		int l = thread->skipped_by_thread(0);
+		int count = thread->count_for_thread(0, NUMCOLORMAPS);
+		while (count > 0)
+		{
+			colormap->BuildLightLevel (l, basecolors);
+			l += thread->num_cores;
+			count--;
+		}
+	}
+};
+
+FDynamicColormap *GetSpecialLights (PalEntry color, PalEntry fade, int desaturate, bool lazy)
 {
 	FDynamicColormap *colormap;
 
 	// If this colormap has already been created, just return it
-	for (colormap = &NormalLight; colormap != NULL; colormap = colormap->Next)
+	if (color == NormalLight.Color &&
+		fade == NormalLight.Fade &&
+		desaturate == NormalLight.Desaturate)
 	{
-		if (color == colormap->Color &&
-			fade == colormap->Fade &&
-			desaturate == colormap->Desaturate)
+		return &NormalLight;
+	}
+
+	FColormapKey key = { color, fade, desaturate };
+	FDynamicColormap **found = SpecialLightsMap.CheckKey(key);
+	if (found != NULL)
+	{
+		colormap = *found;
+		colormap->LastUsed = ColormapCollection;
+		if (colormap->LightsPending && !lazy)
 		{
-			return colormap;
+			// Needed right now, so R_UpdateColormaps can skip it.
+			colormap->LightsPending = false;
+			ColormapBuildCycles.Clock();
+			colormap->BuildLights ();
+			ColormapBuildCycles.Unclock();
+			NumBuiltLights++;
 		}
+		return colormap;
 	}
 
 	// Not found. Create it.
@@ -206,12 +285,26 @@ FDynamicColormap *GetSpecialLights (PalEntry color, PalEntry fade, int desaturat
 	colormap->Color = color;
 	colormap->Fade = fade;
 	colormap->Desaturate = desaturate;
+	colormap->LastUsed = ColormapCollection;
 	NormalLight.Next = colormap;
+	SpecialLightsMap[key] = colormap;
+	NumSpecialLights++;
 
 	if (Renderer->UsesColormap())
 	{
 		colormap->Maps = new BYTE[NUMCOLORMAPS*256];
-		colormap->BuildLights ();
+		if (lazy)
+		{
+			colormap->LightsPending = true;
+			PendingLights.Push(colormap);
+		}
+		else
+		{
+			ColormapBuildCycles.Clock();
+			colormap->BuildLights ();
+			ColormapBuildCycles.Unclock();
+			NumBuiltLights++;
+		}
 	}
 	else colormap->Maps = NULL;
 
@@ -235,6 +328,100 @@ static void FreeSpecialLights()
 		delete colormap;
 	}
 	NormalLight.Next = NULL;
+	SpecialLightsMap.Clear();
+	PendingLights.Clear();
+	NumSpecialLights = 0;
+}
+
+//==========================================================================
+//
+// Frees the lights that are not referenced by the level and that nobody
+// asked GetSpecialLights for since the previous collection. Scripts that
+// change sector colors every tic leave a trail of these behind.
+//
+//==========================================================================
+
+static void CollectSpecialLights()
+{
+	for (int i = 0; i < numsectors; i++)
+	{
+		sectors[i].ColorMap->LastUsed = ColormapCollection;
+		for (auto &light : sectors[i].e->XFloor.lightlist)
+		{
+			if (light.extra_colormap != NULL)
+			{
+				light.extra_colormap->LastUsed = ColormapCollection;
+			}
+		}
+	}
+
+	FDynamicColormap *prev = &NormalLight, *colormap;
+	while ((colormap = prev->Next) != NULL)
+	{
+		if (colormap->LastUsed < ColormapCollection - 1)
+		{
+			FColormapKey key = { colormap->Color, colormap->Fade, colormap->Desaturate };
+			SpecialLightsMap.Remove(key);
+			prev->Next = colormap->Next;
+			delete[] colormap->Maps;
+			delete colormap;
+			NumSpecialLights--;
+			NumCollectedLights++;
+		}
+		else
+		{
+			prev = colormap;
+		}
+	}
+	ColormapCollection++;
+	CollectThreshold = MAX(256, NumSpecialLights * 2);
+}
+
+//==========================================================================
+//
+// R_UpdateColormaps
+//
+// Builds the light tables that GetSpecialLights left for later, spreading
+// them over the drawer threads, and collects unused lights once there are
+// many of them. Must not be called while drawer commands are queued.
+//
+//==========================================================================
+
+void R_UpdateColormaps ()
+{
+	ColormapBuildCycles.Reset();
+	NumBuiltLights = 0;
+
+	if (PendingLights.Size() > 0)
+	{
+		ColormapBuildCycles.Clock();
+		DrawerCommandQueue::Begin();
+		for (auto colormap : PendingLights)
+		{
+			if (colormap->LightsPending)
+			{
+				colormap->LightsPending = false;
+				DrawerCommandQueue::QueueCommand<BuildLightsCommand>(colormap);
+				NumBuiltLights++;
+			}
+		}
+		DrawerCommandQueue::End();
+		PendingLights.Clear();
+		ColormapBuildCycles.Unclock();
+	}
+
+	if (NumSpecialLights > CollectThreshold)
+	{
+		CollectSpecialLights();
+	}
+}
+
+ADD_STAT(colormaps)
+{
+	FString out;
+	out.Format("%d colormaps, %d built in %2.3f ms, %d collected",
+		NumSpecialLights, NumBuiltLights, ColormapBuildCycles.TimeMS(), NumCollectedLights);
+	return out;
 }
 
 //==========================================================================
@@ -245,19 +432,29 @@ static void FreeSpecialLights()
 
 void FDynamicColormap::BuildLights ()
 {
-	int l, c;
-	int lr, lg, lb, ld, ild;
-	PalEntry colors[256], basecolors[256];
-	BYTE *shade;
+	PalEntry basecolors[256];
 
 	if (Maps == NULL)
 		return;
 
-	// Scale light to the range 0-256, so we can avoid
-	// dividing by 255 in the bottom loop.
-	lr = Color.r*256/255;
-	lg = Color.g*256/255;
-	lb = Color.b*256/255;
+	GetBaseColors (basecolors);
+	for (int l = 0; l < NUMCOLORMAPS; l++)
+	{
+		BuildLightLevel (l, basecolors);
+	}
+}
+
+//==========================================================================
+//
+// The palette, desaturated as needed, that the light levels start from
+//
+//==========================================================================
+
+void FDynamicColormap::GetBaseColors (PalEntry basecolors[256])
+{
+	int c;
+	int ld, ild;
+
 	ld = Desaturate*256/255;
 	if (ld < 0)	// No negative desaturations, please.
 	{
@@ -267,7 +464,7 @@ void FDynamicColormap::BuildLights ()
 
 	if (ld == 0)
 	{
-		memcpy (basecolors, GPalette.BaseColors, sizeof(basecolors));
+		memcpy (basecolors, GPalette.BaseColors, sizeof(PalEntry)*256);
 	}
 	else
 	{
@@ -284,30 +481,48 @@ void FDynamicColormap::BuildLights ()
 			basecolors[c].a = 0;
 		}
 	}
+}
+
+//==========================================================================
+//
+// Builds a single light level. This only reads the palette and writes its
+// own part of Maps, so several levels can be built at once.
+//
+//==========================================================================
+
+void FDynamicColormap::BuildLightLevel (int l, const PalEntry *basecolors)
+{
+	int c;
+	int lr, lg, lb;
+	PalEntry colors[256];
+	BYTE *shade;
+
+	// Scale light to the range 0-256, so we can avoid
+	// dividing by 255 in the bottom loop.
+	lr = Color.r*256/255;
+	lg = Color.g*256/255;
+	lb = Color.b*256/255;
 
 	// build normal (but colored) light mappings
-	for (l = 0; l < NUMCOLORMAPS; l++)
-	{
-		DoBlending (basecolors, colors, 256,
-			Fade.r, Fade.g, Fade.b, l * (256 / NUMCOLORMAPS));
+	DoBlending (basecolors, colors, 256,
+		Fade.r, Fade.g, Fade.b, l * (256 / NUMCOLORMAPS));
 
-		shade = Maps + 256*l;
-		if ((DWORD)Color == MAKERGB(255,255,255))
-		{ // White light, so we can just pick the colors directly
-			for (c = 0; c < 256; c++)
-			{
-				*shade++ = ColorMatcher.Pick (colors[c].r, colors[c].g, colors[c].b);
-			}
+	shade = Maps + 256*l;
+	if ((DWORD)Color == MAKERGB(255,255,255))
+	{ // White light, so we can just pick the colors directly
+		for (c = 0; c < 256; c++)
+		{
+			*shade++ = ColorMatcher.Pick (colors[c].r, colors[c].g, colors[c].b);
 		}
-		else
-		{ // Colored light, so do the (slightly) slower thing
-			for (c = 0; c < 256; c++)
-			{
-				*shade++ = ColorMatcher.Pick (
-					(colors[c].r*lr)>>8,
-					(colors[c].g*lg)>>8,
-					(colors[c].b*lb)>>8);
-			}
+	}
+	else
+	{ // Colored light, so do the (slightly) slower thing
+		for (c = 0; c < 256; c++)
+		{
+			*shade++ = ColorMatcher.Pick (
+				(colors[c].r*lr)>>8,
+				(colors[c].g*lg)>>8,
+				(colors[c].b*lb)>>8);
 		}
 	}
 }
@@ -362,7 +577,7 @@ void FDynamicColormap::ChangeColorFade (PalEntry lightcolor, PalEntry fadecolor)
 
 //==========================================================================
 //
-//
+// The tables are only allocated here; R_UpdateColormaps builds them.
 //
 //==========================================================================
 
@@ -372,14 +587,20 @@ void FDynamicColormap::RebuildAllLights()
 	{
 		FDynamicColormap *cm;
 
-		for (cm = &NormalLight; cm != NULL; cm = cm->Next)
+		for (cm = NormalLight.Next; cm != NULL; cm = cm->Next)
 		{
 			if (cm->Maps == NULL)
 			{
 				cm->Maps = new BYTE[NUMCOLORMAPS*256];
-				cm->BuildLights ();
+				cm->LightsPending = true;
+				PendingLights.Push(cm);
 			}
 		}
+		if (NormalLight.Maps == NULL)
+		{
+			NormalLight.Maps = new BYTE[NUMCOLORMAPS*256];
+			NormalLight.BuildLights ();
+		}
 	}
 }
 
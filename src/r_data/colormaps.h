@@ -5,6 +5,7 @@ struct FSWColormap;
 
 void R_InitColormaps ();
 void R_DeinitColormaps ();
+void R_UpdateColormaps ();						// Builds pending light tables and frees unused colormaps
 
 DWORD R_ColormapNumForName(const char *name);	// killough 4/4/98
 void R_SetDefaultColormap (const char *name);	// [RH] change normal fadetable
@@ -26,9 +27,13 @@ struct FDynamicColormap : FSWColormap
 	void ChangeColor (PalEntry lightcolor, int desaturate);
 	void ChangeColorFade (PalEntry lightcolor, PalEntry fadecolor);
 	void BuildLights ();
+	void GetBaseColors (PalEntry basecolors[256]);
+	void BuildLightLevel (int level, const PalEntry *basecolors);
 	static void RebuildAllLights();
 
 	FDynamicColormap *Next;
+	int LastUsed = 0;				// Collection in which this colormap was last used
+	bool LightsPending = false;		// Maps still has to be built by R_UpdateColormaps
 };
 
 // For hardware-accelerated weapon sprites in colored sectors
@@ -93,7 +98,9 @@ extern FDynamicColormap FullNormalLight;
 }
 extern bool NormalLightHasFixedLights;
 
-FDynamicColormap *GetSpecialLights (PalEntry lightcolor, PalEntry fadecolor, int desaturate);
+// With lazy set, a new colormap's light table is not built until the next
+// R_UpdateColormaps, which builds all of them at once on the drawer threads.
+FDynamicColormap *GetSpecialLights (PalEntry lightcolor, PalEntry fadecolor, int desaturate, bool lazy = false);
 
 
 #endif
@@ -41,6 +41,10 @@
 #include "po_man.h"
 #include "serializer.h"
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
 //==========================================================================
 //
 //
@@ -78,13 +82,32 @@ public:
 //
 //==========================================================================
 
-class DSectorScrollInterpolation : public DInterpolation
+class DOffsetInterpolation : public DInterpolation
+{
+	DECLARE_ABSTRACT_CLASS(DOffsetInterpolation, DInterpolation)
+
+protected:
+	bool IsOffsetInterpolation() const { return true; }
+	FInterpolator::FInterpolatedOffset &Data() { return interpolator.Offsets[OffsetIndex]; }
+	void SerializeOffset(FSerializer &arc, double *target);
+
+public:
+	void UpdateInterpolation();
+	void Restore();
+	void Interpolate(double smoothratio);
+};
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+class DSectorScrollInterpolation : public DOffsetInterpolation
 {
-	DECLARE_CLASS(DSectorScrollInterpolation, DInterpolation)
+	DECLARE_CLASS(DSectorScrollInterpolation, DOffsetInterpolation)
 
 	sector_t *sector;
-	double oldx, oldy;
-	double bakx, baky;
 	bool ceiling;
 
 public:
@@ -92,9 +115,6 @@ public:
 	DSectorScrollInterpolation() {}
 	DSectorScrollInterpolation(sector_t *sector, bool plane);
 	void Destroy();
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -106,23 +126,18 @@ public:
 //
 //==========================================================================
 
-class DWallScrollInterpolation : public DInterpolation
+class DWallScrollInterpolation : public DOffsetInterpolation
 {
-	DECLARE_CLASS(DWallScrollInterpolation, DInterpolation)
+	DECLARE_CLASS(DWallScrollInterpolation, DOffsetInterpolation)
 
 	side_t *side;
 	int part;
-	double oldx, oldy;
-	double bakx, baky;
 
 public:
 
 	DWallScrollInterpolation() {}
 	DWallScrollInterpolation(side_t *side, int part);
 	void Destroy();
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -166,6 +181,7 @@ DECLARE_POINTER(Next)
 DECLARE_POINTER(Prev)
 END_POINTERS
 IMPLEMENT_CLASS(DSectorPlaneInterpolation)
+IMPLEMENT_ABSTRACT_CLASS(DOffsetInterpolation)
 IMPLEMENT_CLASS(DSectorScrollInterpolation)
 IMPLEMENT_CLASS(DWallScrollInterpolation)
 IMPLEMENT_CLASS(DPolyobjInterpolation)
@@ -209,6 +225,11 @@ void FInterpolator::UpdateInterpolations()
 	{
 		probe->UpdateInterpolation ();
 	}
+	for (unsigned i = 0; i < Offsets.Size(); i++)
+	{
+		Offsets[i].Old[0] = Offsets[i].Target[0];
+		Offsets[i].Old[1] = Offsets[i].Target[1];
+	}
 }
 
 //==========================================================================
@@ -232,8 +253,41 @@ void FInterpolator::AddInterpolation(DInterpolation *interp)
 //
 //==========================================================================
 
+void FInterpolator::AddOffsetInterpolation(DInterpolation *interp, double *target)
+{
+	FInterpolatedOffset data;
+
+	data.Target = target;
+	data.Old[0] = data.Bak[0] = target[0];
+	data.Old[1] = data.Bak[1] = target[1];
+	data.Owner = interp;
+	interp->OffsetIndex = Offsets.Push(data);
+	count++;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void FInterpolator::RemoveInterpolation(DInterpolation *interp)
 {
+	if (interp->OffsetIndex >= 0)
+	{
+		// Fill the gap with the last entry.
+		unsigned index = interp->OffsetIndex;
+		unsigned last = Offsets.Size() - 1;
+		if (index != last)
+		{
+			Offsets[index] = Offsets[last];
+			Offsets[index].Owner->OffsetIndex = index;
+		}
+		Offsets.Pop();
+		interp->OffsetIndex = -1;
+		count--;
+		return;
+	}
 	if (Head == interp)
 	{
 		Head = interp->Next;
@@ -272,6 +326,37 @@ void FInterpolator::DoInterpolations(double smoothratio)
 		probe->Interpolate(smoothratio);
 		probe = next;
 	}
+
+	// Walk the offsets backwards so that an entry that gets destroyed
+	// is replaced by one that has already been processed.
+#ifndef NO_SSE
+	__m128d ratio = _mm_set1_pd(smoothratio);
+#endif
+	for (int i = int(Offsets.Size()) - 1; i >= 0; i--)
+	{
+		FInterpolatedOffset &data = Offsets[i];
+#ifndef NO_SSE
+		__m128d old = _mm_loadu_pd(data.Old);
+		__m128d cur = _mm_loadu_pd(data.Target);
+		_mm_storeu_pd(data.Bak, cur);
+		if (data.Owner->refcount == 0 && _mm_movemask_pd(_mm_cmpeq_pd(old, cur)) == 3)
+		{
+			data.Owner->Destroy();
+			continue;
+		}
+		_mm_storeu_pd(data.Target, _mm_add_pd(old, _mm_mul_pd(_mm_sub_pd(cur, old), ratio)));
+#else
+		data.Bak[0] = data.Target[0];
+		data.Bak[1] = data.Target[1];
+		if (data.Owner->refcount == 0 && data.Old[0] == data.Bak[0] && data.Old[1] == data.Bak[1])
+		{
+			data.Owner->Destroy();
+			continue;
+		}
+		data.Target[0] = data.Old[0] + (data.Bak[0] - data.Old[0]) * smoothratio;
+		data.Target[1] = data.Old[1] + (data.Bak[1] - data.Old[1]) * smoothratio;
+#endif
+	}
 }
 
 //==========================================================================
@@ -289,6 +374,11 @@ void FInterpolator::RestoreInterpolations()
 		{
 			probe->Restore();
 		}
+		for (unsigned i = 0; i < Offsets.Size(); i++)
+		{
+			Offsets[i].Target[0] = Offsets[i].Bak[0];
+			Offsets[i].Target[1] = Offsets[i].Bak[1];
+		}
 	}
 }
 
@@ -309,6 +399,25 @@ void FInterpolator::ClearInterpolations()
 		probe->Destroy();
 		probe = next;
 	}
+	while (Offsets.Size() > 0)
+	{
+		Offsets.Last().Owner->Destroy();
+	}
+}
+
+//==========================================================================
+//
+// The offset interpolations aren't reachable through the list so they
+// need to be marked separately.
+//
+//==========================================================================
+
+void FInterpolator::MarkOffsetInterpolations()
+{
+	for (unsigned i = 0; i < Offsets.Size(); i++)
+	{
+		GC::Mark(Offsets[i].Owner);
+	}
 }
 
 
@@ -329,6 +438,7 @@ DInterpolation::DInterpolation()
 	Next = NULL;
 	Prev = NULL;
 	refcount = 0;
+	OffsetIndex = -1;
 }
 
 //==========================================================================
@@ -378,7 +488,7 @@ void DInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
 	arc("refcount", refcount);
-	if (arc.isReading())
+	if (arc.isReading() && !IsOffsetInterpolation())
 	{
 		interpolator.AddInterpolation(this);
 	}
@@ -570,22 +680,30 @@ size_t DSectorPlaneInterpolation::PropagateMark()
 
 //==========================================================================
 //
-//
+// Offset interpolations are normally processed in bulk by the
+// interpolator. These only exist so that they can also be used
+// like any other interpolation.
 //
 //==========================================================================
 
+void DOffsetInterpolation::UpdateInterpolation()
+{
+	FInterpolator::FInterpolatedOffset &data = Data();
+	data.Old[0] = data.Target[0];
+	data.Old[1] = data.Target[1];
+}
+
 //==========================================================================
 //
 //
 //
 //==========================================================================
 
-DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _plane)
+void DOffsetInterpolation::Restore()
 {
-	sector = _sector;
-	ceiling = _plane;
-	UpdateInterpolation ();
-	interpolator.AddInterpolation(this);
+	FInterpolator::FInterpolatedOffset &data = Data();
+	data.Target[0] = data.Bak[0];
+	data.Target[1] = data.Bak[1];
 }
 
 //==========================================================================
@@ -594,33 +712,42 @@ DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::Destroy()
+void DOffsetInterpolation::Interpolate(double smoothratio)
 {
-	if (sector != nullptr)
+	FInterpolator::FInterpolatedOffset &data = Data();
+	data.Bak[0] = data.Target[0];
+	data.Bak[1] = data.Target[1];
+
+	if (refcount == 0 && data.Old[0] == data.Bak[0] && data.Old[1] == data.Bak[1])
 	{
-		if (ceiling)
-		{
-			sector->interpolations[sector_t::CeilingScroll] = nullptr;
-		}
-		else
-		{
-			sector->interpolations[sector_t::FloorScroll] = nullptr;
-		}
-		sector = nullptr;
+		Destroy();
+	}
+	else
+	{
+		data.Target[0] = data.Old[0] + (data.Bak[0] - data.Old[0]) * smoothratio;
+		data.Target[1] = data.Old[1] + (data.Bak[1] - data.Old[1]) * smoothratio;
 	}
-	Super::Destroy();
 }
 
 //==========================================================================
 //
-//
+// Registers a loaded interpolation with the interpolator before
+// reading its old offsets.
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::UpdateInterpolation()
+void DOffsetInterpolation::SerializeOffset(FSerializer &arc, double *target)
 {
-	oldx = sector->GetXOffset(ceiling);
-	oldy = sector->GetYOffset(ceiling, false);
+	if (arc.isReading())
+	{
+		interpolator.AddOffsetInterpolation(this, target);
+	}
+	if (OffsetIndex >= 0)
+	{
+		FInterpolator::FInterpolatedOffset &data = Data();
+		arc("oldx", data.Old[0])
+			("oldy", data.Old[1]);
+	}
 }
 
 //==========================================================================
@@ -629,10 +756,17 @@ void DSectorScrollInterpolation::UpdateInterpolation()
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::Restore()
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _plane)
 {
-	sector->SetXOffset(ceiling, bakx);
-	sector->SetYOffset(ceiling, baky);
+	sector = _sector;
+	ceiling = _plane;
+	interpolator.AddOffsetInterpolation(this, &sector->planes[ceiling ? sector_t::ceiling : sector_t::floor].xform.xOffs);
 }
 
 //==========================================================================
@@ -641,20 +775,21 @@ void DSectorScrollInterpolation::Restore()
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::Interpolate(double smoothratio)
+void DSectorScrollInterpolation::Destroy()
 {
-	bakx = sector->GetXOffset(ceiling);
-	baky = sector->GetYOffset(ceiling, false);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		Destroy();
-	}
-	else
+	if (sector != nullptr)
 	{
-		sector->SetXOffset(ceiling, oldx + (bakx - oldx) * smoothratio);
-		sector->SetYOffset(ceiling, oldy + (baky - oldy) * smoothratio);
+		if (ceiling)
+		{
+			sector->interpolations[sector_t::CeilingScroll] = nullptr;
+		}
+		else
+		{
+			sector->interpolations[sector_t::FloorScroll] = nullptr;
+		}
+		sector = nullptr;
 	}
+	Super::Destroy();
 }
 
 //==========================================================================
@@ -667,9 +802,8 @@ void DSectorScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
 	arc("sector", sector)
-		("ceiling", ceiling)
-		("oldx", oldx)
-		("oldy", oldy);
+		("ceiling", ceiling);
+	SerializeOffset(arc, &sector->planes[ceiling ? sector_t::ceiling : sector_t::floor].xform.xOffs);
 }
 
 
@@ -689,8 +823,7 @@ DWallScrollInterpolation::DWallScrollInterpolation(side_t *_side, int _part)
 {
 	side = _side;
 	part = _part;
-	UpdateInterpolation ();
-	interpolator.AddInterpolation(this);
+	interpolator.AddOffsetInterpolation(this, &side->textures[part].xOffset);
 }
 
 //==========================================================================
@@ -715,59 +848,12 @@ void DWallScrollInterpolation::Destroy()
 //
 //==========================================================================
 
-void DWallScrollInterpolation::UpdateInterpolation()
-{
-	oldx = side->GetTextureXOffset(part);
-	oldy = side->GetTextureYOffset(part);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DWallScrollInterpolation::Restore()
-{
-	side->SetTextureXOffset(part, bakx);
-	side->SetTextureYOffset(part, baky);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DWallScrollInterpolation::Interpolate(double smoothratio)
-{
-	bakx = side->GetTextureXOffset(part);
-	baky = side->GetTextureYOffset(part);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		Destroy();
-	}
-	else
-	{
-		side->SetTextureXOffset(part, oldx + (bakx - oldx) * smoothratio);
-		side->SetTextureYOffset(part, oldy + (baky - oldy) * smoothratio);
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
 void DWallScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
 	arc("side", side)
-		("part", part)
-		("oldx", oldx)
-		("oldy", oldy);
+		("part", part);
+	SerializeOffset(arc, &side->textures[part].xOffset);
 }
 
 //==========================================================================
@@ -20,9 +20,15 @@ class DInterpolation : public DObject
 
 protected:
 	int refcount;
+	int OffsetIndex;	// slot in FInterpolator::Offsets, -1 if linked into the list
 
 	DInterpolation();
 
+	// Interpolations of a plain x/y offset pair are not linked into the list
+	// but kept in a flat array by the interpolator so that they can be
+	// processed in bulk.
+	virtual bool IsOffsetInterpolation() const { return false; }
+
 public:
 	int AddRef();
 	int DelRef(bool force = false);
@@ -43,7 +49,16 @@ public:
 
 struct FInterpolator
 {
+	struct FInterpolatedOffset
+	{
+		double *Target;		// points to an x offset immediately followed by its y offset
+		double Old[2];
+		double Bak[2];
+		DInterpolation *Owner;
+	};
+
 	TObjPtr<DInterpolation> Head;
+	TArray<FInterpolatedOffset> Offsets;
 	bool didInterp;
 	int count;
 
@@ -58,7 +73,9 @@ public:
 	}
 	void UpdateInterpolations();
 	void AddInterpolation(DInterpolation *);
+	void AddOffsetInterpolation(DInterpolation *, double *target);
 	void RemoveInterpolation(DInterpolation *);
+	void MarkOffsetInterpolations();
 	void DoInterpolations(double smoothratio);
 	void RestoreInterpolations();
 	void ClearInterpolations();
@@ -569,6 +569,7 @@ struct extsector_t
 		TDeletingArray<F3DFloor *>		ffloors;		// 3D floors in this sector
 		TArray<lightlist_t>				lightlist;		// 3D light list
 		TArray<sector_t*>				attached;		// 3D floors attached to this sector
+		F3DFloorSortKey					sortkey;		// for P_Update3DFloors
 	} XFloor;
 
 	TArray<vertex_t *> vertices;
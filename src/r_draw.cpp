@@ -40,6 +40,7 @@
 #include "r_data/colormaps.h"
 #include "r_plane.h"
 #include "r_draw_rgba.h"
+#include "r_draw_pal.h"
 
 #include "gi.h"
 #include "stats.h"
@@ -1666,6 +1667,9 @@ extern "C" void R_DrawSlabC(int dx, fixed_t v, int dy, fixed_t vi, const BYTE *v
 int vlinebits;
 int mvlinebits;
 
+// Set by R_InitColumnDrawers when the paletted drawers are queued
+static bool queue_pal_drawers;
+
 #ifndef X86_ASM
 static DWORD vlinec1 ();
 
@@ -1716,7 +1720,7 @@ void (*domvline4)() = mvlineasm4;
 
 void setupvline (int fracbits)
 {
-	if (r_swtruecolor)
+	if (r_swtruecolor || queue_pal_drawers)
 	{
 		vlinebits = fracbits;
 		return;
@@ -1837,7 +1841,7 @@ void vlinec4()
 
 void setupmvline (int fracbits)
 {
-	if (!r_swtruecolor)
+	if (!r_swtruecolor && !queue_pal_drawers)
 	{
 #if defined(X86_ASM)
 		setupmvlineasm(fracbits);
@@ -2709,6 +2713,7 @@ const BYTE *R_GetColumn (FTexture *tex, int col)
 void R_DetailDouble ()
 {
 	if (!viewactive) return;
+	DrawerCommandQueue::WaitForWorkers();
 	DetailDoubleCycles.Reset();
 	DetailDoubleCycles.Clock();
 
@@ -2942,18 +2947,21 @@ void R_InitColumnDrawers ()
 	static void(*dovline4_saved)();
 	static void(*domvline4_saved)();
 
-	if (r_swtruecolor)
+	// The queued paletted drawers replace the wall drawers too
+	queue_pal_drawers = !r_swtruecolor && r_multithreaded;
+
+	if ((r_swtruecolor || queue_pal_drawers) && !pointers_saved)
 	{
-		if (!pointers_saved)
-		{
-			pointers_saved = true;
-			dovline1_saved = dovline1;
-			doprevline1_saved = doprevline1;
-			domvline1_saved = domvline1;
-			dovline4_saved = dovline4;
-			domvline4_saved = domvline4;
-		}
+		pointers_saved = true;
+		dovline1_saved = dovline1;
+		doprevline1_saved = doprevline1;
+		domvline1_saved = domvline1;
+		dovline4_saved = dovline4;
+		domvline4_saved = domvline4;
+	}
 
+	if (r_swtruecolor)
+	{
 		R_DrawColumnHoriz			= R_DrawColumnHoriz_rgba;
 		R_DrawColumn				= R_DrawColumn_rgba;
 		R_DrawFuzzColumn			= R_DrawFuzzColumn_rgba;
@@ -3140,7 +3148,11 @@ void R_InitColumnDrawers ()
 		rt_initcols					= rt_initcols_pal;
 		rt_span_coverage			= rt_span_coverage_pal;
 
-		if (pointers_saved)
+		if (queue_pal_drawers)
+		{
+			R_InitQueuedPalDrawers();
+		}
+		else if (pointers_saved)
 		{
 			pointers_saved = false;
 			dovline1 = dovline1_saved;
@@ -0,0 +1,1394 @@
+// Emacs style mode select	 -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//		Paletted span/column drawing functions that are queued as commands
+//		and executed by the drawer worker threads. Each command snapshots
+//		the dc_*/ds_* state it needs and every thread only writes the rows
+//		it owns, so the output is identical to the inline drawers in
+//		r_draw.cpp and r_drawt.cpp.
+//
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#include "templates.h"
+#include "doomdef.h"
+#include "r_local.h"
+#include "v_video.h"
+#include "r_plane.h"
+#include "r_things.h"
+#include "r_draw_rgba.h"
+#include "r_draw_pal.h"
+
+extern "C" short spanend[MAXHEIGHT];
+extern unsigned int *horizspan[4];
+extern int vlinebits;
+extern int mvlinebits;
+extern int tmvlinebits;
+
+/////////////////////////////////////////////////////////////////////////////
+// Blend operations:
+//
+// The foreground is passed in as an RGB table entry (dc_srcblend or
+// dc_srccolor) and the background as the dc_destblend entry of the pixel
+// underneath. The arithmetic matches the inline drawers exactly.
+
+struct PalBlendAdd
+{
+	static BYTE Blend(DWORD fg, DWORD bg)
+	{
+		fg = (fg + bg) | 0x1f07c1f;
+		return RGB32k.All[fg & (fg >> 15)];
+	}
+};
+
+struct PalBlendAddClamp
+{
+	static BYTE Blend(DWORD fg, DWORD bg)
+	{
+		DWORD a = fg + bg;
+		DWORD b = a;
+
+		a |= 0x01f07c1f;
+		b &= 0x40100400;
+		a &= 0x3fffffff;
+		b = b - (b >> 5);
+		a |= b;
+		return RGB32k.All[a & (a >> 15)];
+	}
+};
+
+struct PalBlendSubClamp
+{
+	static BYTE Blend(DWORD fg, DWORD bg)
+	{
+		DWORD a = (fg | 0x40100400) - bg;
+		DWORD b = a;
+
+		b &= 0x40100400;
+		b = b - (b >> 5);
+		a &= b;
+		a |= 0x01f07c1f;
+		return RGB32k.All[a & (a >> 15)];
+	}
+};
+
+struct PalBlendRevSubClamp
+{
+	static BYTE Blend(DWORD fg, DWORD bg)
+	{
+		DWORD a = (bg | 0x40100400) - fg;
+		DWORD b = a;
+
+		b &= 0x40100400;
+		b = b - (b >> 5);
+		a &= b;
+		a |= 0x01f07c1f;
+		return RGB32k.All[a & (a >> 15)];
+	}
+};
+
+// Used by the shaded drawers: the source is an alpha level for dc_color.
+static inline BYTE PalShade(const DWORD *fgstart, DWORD val, BYTE bg)
+{
+	DWORD fg = fgstart[val << 8];
+	val = (Col2RGB8[64 - val][bg] + fg) | 0x1f07c1f;
+	return RGB32k.All[val & (val >> 15)];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Column drawers:
+
+class PalColumnCommand : public DrawerCommand
+{
+public:
+	int _count;
+	BYTE * RESTRICT _dest;
+	int _pitch;
+	DWORD _iscale;
+	DWORD _texturefrac;
+	const BYTE * RESTRICT _colormap;
+	const BYTE * RESTRICT _source;
+	const BYTE * RESTRICT _translation;
+	BYTE _color;
+	DWORD _srccolor;
+	const DWORD * RESTRICT _srcblend;
+	const DWORD * RESTRICT _destblend;
+
+	PalColumnCommand()
+	{
+		_count = dc_count;
+		_dest = dc_dest;
+		_pitch = dc_pitch;
+		_iscale = dc_iscale;
+		_texturefrac = dc_texturefrac;
+		_colormap = dc_colormap;
+		_source = dc_source;
+		_translation = dc_translation;
+		_color = dc_color;
+		_srccolor = dc_srccolor;
+		_srcblend = dc_srcblend;
+		_destblend = dc_destblend;
+	}
+
+	class LoopIterator
+	{
+	public:
+		int count;
+		BYTE *dest;
+		int pitch;
+		DWORD fracstep;
+		DWORD frac;
+
+		LoopIterator(PalColumnCommand *command, DrawerThread *thread)
+		{
+			count = thread->count_for_thread(command->_dest_y, command->_count);
+			if (count <= 0)
+				return;
+
+			int skipped = thread->skipped_by_thread(command->_dest_y);
+			dest = command->_dest + skipped * command->_pitch;
+			pitch = command->_pitch * thread->num_cores;
+
+			fracstep = command->_iscale * thread->num_cores;
+			frac = command->_texturefrac + command->_iscale * skipped;
+		}
+
+		// The inline drawers step a signed fixed_t, so shift it the same way.
+		int sample_index()
+		{
+			return ((fixed_t)frac) >> FRACBITS;
+		}
+
+		explicit operator bool()
+		{
+			return count > 0;
+		}
+
+		bool next()
+		{
+			dest += pitch;
+			frac += fracstep;
+			return (--count) != 0;
+		}
+	};
+};
+
+template<bool Translated>
+class DrawColumnPalCommand : public PalColumnCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (Translated) pix = _translation[pix];
+			*loop.dest = _colormap[pix];
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode, bool Translated>
+class DrawBlendColumnPalCommand : public PalColumnCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (Translated) pix = _translation[pix];
+			*loop.dest = BlendMode::Blend(_srcblend[_colormap[pix]], _destblend[*loop.dest]);
+		} while (loop.next());
+	}
+};
+
+class DrawShadedColumnPalCommand : public PalColumnCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		const DWORD *fgstart = &Col2RGB8[0][_color];
+		do
+		{
+			*loop.dest = PalShade(fgstart, _colormap[_source[loop.sample_index()]], *loop.dest);
+		} while (loop.next());
+	}
+};
+
+class FillColumnPalCommand : public PalColumnCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			*loop.dest = _color;
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode>
+class FillBlendColumnPalCommand : public PalColumnCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			*loop.dest = BlendMode::Blend(_srccolor, _destblend[*loop.dest]);
+		} while (loop.next());
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Wall drawers:
+
+class PalWall1Command : public DrawerCommand
+{
+public:
+	int _count;
+	BYTE * RESTRICT _dest;
+	int _pitch;
+	DWORD _iscale;
+	DWORD _texturefrac;
+	int _bits;
+	const BYTE * RESTRICT _colormap;
+	const BYTE * RESTRICT _source;
+	const DWORD * RESTRICT _srcblend;
+	const DWORD * RESTRICT _destblend;
+
+	PalWall1Command(int bits)
+	{
+		_count = dc_count;
+		_dest = dc_dest;
+		_pitch = dc_pitch;
+		_iscale = dc_iscale;
+		_texturefrac = dc_texturefrac;
+		_bits = bits;
+		_colormap = dc_colormap;
+		_source = dc_source;
+		_srcblend = dc_srcblend;
+		_destblend = dc_destblend;
+	}
+
+	class LoopIterator
+	{
+	public:
+		int count;
+		BYTE *dest;
+		int pitch;
+		DWORD fracstep;
+		DWORD frac;
+		int bits;
+
+		LoopIterator(PalWall1Command *command, DrawerThread *thread)
+		{
+			count = thread->count_for_thread(command->_dest_y, command->_count);
+			if (count <= 0)
+				return;
+
+			int skipped = thread->skipped_by_thread(command->_dest_y);
+			dest = command->_dest + skipped * command->_pitch;
+			pitch = command->_pitch * thread->num_cores;
+
+			fracstep = command->_iscale * thread->num_cores;
+			frac = command->_texturefrac + command->_iscale * skipped;
+			bits = command->_bits;
+		}
+
+		DWORD sample_index()
+		{
+			return frac >> bits;
+		}
+
+		explicit operator bool()
+		{
+			return count > 0;
+		}
+
+		bool next()
+		{
+			dest += pitch;
+			frac += fracstep;
+			return (--count) != 0;
+		}
+	};
+};
+
+class PalWall4Command : public DrawerCommand
+{
+public:
+	int _count;
+	BYTE * RESTRICT _dest;
+	int _pitch;
+	int _bits;
+	DWORD _vplce[4];
+	DWORD _vince[4];
+	const BYTE * RESTRICT _palookupoffse[4];
+	const BYTE * RESTRICT _bufplce[4];
+	const DWORD * RESTRICT _srcblend;
+	const DWORD * RESTRICT _destblend;
+
+	PalWall4Command(int bits)
+	{
+		_count = dc_count;
+		_dest = dc_dest;
+		_pitch = dc_pitch;
+		_bits = bits;
+		for (int i = 0; i < 4; i++)
+		{
+			_vplce[i] = vplce[i];
+			_vince[i] = vince[i];
+			_palookupoffse[i] = palookupoffse[i];
+			_bufplce[i] = bufplce[i];
+		}
+		_srcblend = dc_srcblend;
+		_destblend = dc_destblend;
+	}
+
+	class LoopIterator
+	{
+	public:
+		int count;
+		BYTE *dest;
+		int pitch;
+		DWORD vplce[4];
+		DWORD vince[4];
+		int bits;
+
+		LoopIterator(PalWall4Command *command, DrawerThread *thread)
+		{
+			count = thread->count_for_thread(command->_dest_y, command->_count);
+			if (count <= 0)
+				return;
+
+			int skipped = thread->skipped_by_thread(command->_dest_y);
+			dest = command->_dest + skipped * command->_pitch;
+			pitch = command->_pitch * thread->num_cores;
+
+			for (int i = 0; i < 4; i++)
+			{
+				vplce[i] = command->_vplce[i] + command->_vince[i] * skipped;
+				vince[i] = command->_vince[i] * thread->num_cores;
+			}
+			bits = command->_bits;
+		}
+
+		DWORD sample_index(int col)
+		{
+			return vplce[col] >> bits;
+		}
+
+		explicit operator bool()
+		{
+			return count > 0;
+		}
+
+		bool next()
+		{
+			vplce[0] += vince[0];
+			vplce[1] += vince[1];
+			vplce[2] += vince[2];
+			vplce[3] += vince[3];
+			dest += pitch;
+			return (--count) != 0;
+		}
+	};
+};
+
+template<bool Masked>
+class Vline1PalCommand : public PalWall1Command
+{
+public:
+	Vline1PalCommand(int bits) : PalWall1Command(bits) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (!Masked || pix != 0)
+				*loop.dest = _colormap[pix];
+		} while (loop.next());
+	}
+};
+
+template<bool Masked>
+class Vline4PalCommand : public PalWall4Command
+{
+public:
+	Vline4PalCommand(int bits) : PalWall4Command(bits) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				BYTE pix = _bufplce[i][loop.sample_index(i)];
+				if (!Masked || pix != 0)
+					loop.dest[i] = _palookupoffse[i][pix];
+			}
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode>
+class Tmvline1PalCommand : public PalWall1Command
+{
+public:
+	Tmvline1PalCommand() : PalWall1Command(tmvlinebits) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (pix != 0)
+				*loop.dest = BlendMode::Blend(_srcblend[_colormap[pix]], _destblend[*loop.dest]);
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode>
+class Tmvline4PalCommand : public PalWall4Command
+{
+public:
+	Tmvline4PalCommand() : PalWall4Command(tmvlinebits) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				BYTE pix = _bufplce[i][loop.sample_index(i)];
+				if (pix != 0)
+					loop.dest[i] = BlendMode::Blend(_srcblend[_palookupoffse[i][pix]], _destblend[loop.dest[i]]);
+			}
+		} while (loop.next());
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Span drawers:
+
+class PalSpanCommand : public DrawerCommand
+{
+public:
+	dsfixed_t _xfrac;
+	dsfixed_t _yfrac;
+	dsfixed_t _xstep;
+	dsfixed_t _ystep;
+	int _x1;
+	int _x2;
+	int _y;
+	int _xbits;
+	int _ybits;
+	BYTE * RESTRICT _destorg;
+	const BYTE * RESTRICT _source;
+	const BYTE * RESTRICT _colormap;
+	const DWORD * RESTRICT _srcblend;
+	const DWORD * RESTRICT _destblend;
+
+	PalSpanCommand()
+	{
+		_xfrac = ds_xfrac;
+		_yfrac = ds_yfrac;
+		_xstep = ds_xstep;
+		_ystep = ds_ystep;
+		_x1 = ds_x1;
+		_x2 = ds_x2;
+		_y = ds_y;
+		_xbits = ds_xbits;
+		_ybits = ds_ybits;
+		_destorg = dc_destorg;
+		_source = ds_source;
+		_colormap = ds_colormap;
+		_srcblend = dc_srcblend;
+		_destblend = dc_destblend;
+	}
+
+	class LoopIterator
+	{
+	public:
+		BYTE *dest;
+		int count;
+		dsfixed_t xfrac;
+		dsfixed_t yfrac;
+		dsfixed_t xstep;
+		dsfixed_t ystep;
+		BYTE yshift;
+		BYTE xshift;
+		int xmask;
+
+		LoopIterator(PalSpanCommand *command, DrawerThread *thread)
+		{
+			if (thread->line_skipped_by_thread(command->_y))
+			{
+				count = 0;
+				return;
+			}
+
+			dest = ylookup[command->_y] + command->_x1 + command->_destorg;
+			count = command->_x2 - command->_x1 + 1;
+			xfrac = command->_xfrac;
+			yfrac = command->_yfrac;
+			xstep = command->_xstep;
+			ystep = command->_ystep;
+
+			// For 64x64 this is the same index as the special case in R_DrawSpanP_C.
+			yshift = 32 - command->_ybits;
+			xshift = yshift - command->_xbits;
+			xmask = ((1 << command->_xbits) - 1) << command->_ybits;
+		}
+
+		int sample_index()
+		{
+			return ((xfrac >> xshift) & xmask) + (yfrac >> yshift);
+		}
+
+		explicit operator bool()
+		{
+			return count > 0;
+		}
+
+		bool next()
+		{
+			dest++;
+			xfrac += xstep;
+			yfrac += ystep;
+			return (--count) != 0;
+		}
+	};
+};
+
+template<bool Masked>
+class DrawSpanPalCommand : public PalSpanCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (!Masked || pix != 0)
+				*loop.dest = _colormap[pix];
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode, bool Masked>
+class DrawBlendSpanPalCommand : public PalSpanCommand
+{
+public:
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			BYTE pix = _source[loop.sample_index()];
+			if (!Masked || pix != 0)
+				*loop.dest = BlendMode::Blend(_srcblend[_colormap[pix]], _destblend[*loop.dest]);
+		} while (loop.next());
+	}
+};
+
+class FillSpanPalCommand : public DrawerCommand
+{
+	int _y;
+	int _x1;
+	int _x2;
+	BYTE _color;
+	BYTE * RESTRICT _destorg;
+
+public:
+	FillSpanPalCommand(int y, int x1, int x2)
+	{
+		_y = y;
+		_x1 = x1;
+		_x2 = x2;
+		_color = ds_color;
+		_destorg = dc_destorg;
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		if (thread->line_skipped_by_thread(_y))
+			return;
+
+		memset(ylookup[_y] + _x1 + _destorg, _color, _x2 - _x1 + 1);
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Horizontal column drawers (r_drawt.cpp):
+//
+// Every thread keeps its own dc_temp. Both the commands filling it and the
+// ones moving it to the screen only touch the rows owned by the thread, so
+// an offscreen buffer passed to rt_initcols can be shared between them.
+
+class PalRtCommand : public DrawerCommand
+{
+public:
+	int _hx;
+	int _sx;
+	int _yl;
+	int _yh;
+	BYTE * RESTRICT _destorg;
+	int _pitch;
+	const BYTE * RESTRICT _colormap;
+	BYTE _color;
+	const DWORD * RESTRICT _srcblend;
+	const DWORD * RESTRICT _destblend;
+
+	PalRtCommand(int hx, int sx, int yl, int yh)
+	{
+		_hx = hx;
+		_sx = sx;
+		_yl = yl;
+		_yh = yh;
+		_destorg = dc_destorg;
+		_pitch = dc_pitch;
+		_colormap = dc_colormap;
+		_color = dc_color;
+		_srcblend = dc_srcblend;
+		_destblend = dc_destblend;
+	}
+
+	class LoopIterator
+	{
+	public:
+		BYTE *source;
+		BYTE *dest;
+		int count;
+		int pitch;
+		int sincr;
+
+		LoopIterator(PalRtCommand *command, DrawerThread *thread)
+		{
+			count = thread->count_for_thread(command->_yl, command->_yh - command->_yl + 1);
+			if (count <= 0)
+				return;
+
+			int skipped = thread->skipped_by_thread(command->_yl);
+			dest = ylookup[command->_yl] + command->_sx + command->_destorg + skipped * command->_pitch;
+			source = &thread->dc_temp[command->_yl * 4 + command->_hx] + skipped * 4;
+			pitch = command->_pitch * thread->num_cores;
+			sincr = thread->num_cores * 4;
+		}
+
+		explicit operator bool()
+		{
+			return count > 0;
+		}
+
+		bool next()
+		{
+			dest += pitch;
+			source += sincr;
+			return (--count) != 0;
+		}
+	};
+};
+
+template<int Columns>
+class RtCopyPalCommand : public PalRtCommand
+{
+public:
+	RtCopyPalCommand(int hx, int sx, int yl, int yh) : PalRtCommand(hx, sx, yl, yh) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			for (int i = 0; i < Columns; i++)
+				loop.dest[i] = loop.source[i];
+		} while (loop.next());
+	}
+};
+
+template<int Columns>
+class RtMapPalCommand : public PalRtCommand
+{
+public:
+	RtMapPalCommand(int hx, int sx, int yl, int yh) : PalRtCommand(hx, sx, yl, yh) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			for (int i = 0; i < Columns; i++)
+				loop.dest[i] = _colormap[loop.source[i]];
+		} while (loop.next());
+	}
+};
+
+template<int Columns>
+class RtShadedPalCommand : public PalRtCommand
+{
+public:
+	RtShadedPalCommand(int hx, int sx, int yl, int yh) : PalRtCommand(hx, sx, yl, yh) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		const DWORD *fgstart = &Col2RGB8[0][_color];
+		do
+		{
+			for (int i = 0; i < Columns; i++)
+				loop.dest[i] = PalShade(fgstart, _colormap[loop.source[i]], loop.dest[i]);
+		} while (loop.next());
+	}
+};
+
+template<typename BlendMode, int Columns>
+class RtBlendPalCommand : public PalRtCommand
+{
+public:
+	RtBlendPalCommand(int hx, int sx, int yl, int yh) : PalRtCommand(hx, sx, yl, yh) { }
+
+	void Execute(DrawerThread *thread) override
+	{
+		LoopIterator loop(this, thread);
+		if (!loop) return;
+		do
+		{
+			for (int i = 0; i < Columns; i++)
+				loop.dest[i] = BlendMode::Blend(_srcblend[_colormap[loop.source[i]]], _destblend[loop.dest[i]]);
+		} while (loop.next());
+	}
+};
+
+class RtTranslatePalCommand : public DrawerCommand
+{
+	const BYTE * RESTRICT _translation;
+	int _hx;
+	int _columns;
+	int _yl;
+	int _yh;
+
+public:
+	RtTranslatePalCommand(const BYTE *translation, int hx, int columns, int yl, int yh)
+	{
+		_translation = translation;
+		_hx = hx;
+		_columns = columns;
+		_yl = yl;
+		_yh = yh;
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		int count = thread->count_for_thread(_yl, _yh - _yl + 1);
+		if (count <= 0)
+			return;
+
+		BYTE *source = &thread->dc_temp[_yl * 4 + _hx] + thread->skipped_by_thread(_yl) * 4;
+		int sincr = thread->num_cores * 4;
+		do
+		{
+			for (int i = 0; i < _columns; i++)
+				source[i] = _translation[source[i]];
+			source += sincr;
+		} while (--count);
+	}
+};
+
+class RtInitColsPalCommand : public DrawerCommand
+{
+	BYTE * RESTRICT _buff;
+
+public:
+	RtInitColsPalCommand(BYTE *buff)
+	{
+		_buff = buff;
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		thread->dc_temp = _buff == NULL ? thread->dc_temp_buff : _buff;
+	}
+};
+
+class DrawColumnHorizPalCommand : public DrawerCommand
+{
+	int _count;
+	DWORD _iscale;
+	DWORD _texturefrac;
+	const BYTE * RESTRICT _source;
+	int _x;
+	int _yl;
+
+public:
+	DrawColumnHorizPalCommand()
+	{
+		_count = dc_count;
+		_iscale = dc_iscale;
+		_texturefrac = dc_texturefrac;
+		_source = dc_source;
+		_x = dc_x;
+		_yl = dc_yl;
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		int count = thread->count_for_thread(_yl, _count);
+		if (count <= 0)
+			return;
+
+		int skipped = thread->skipped_by_thread(_yl);
+		BYTE *dest = &thread->dc_temp[(_x & 3) + 4 * (_yl + skipped)];
+		int dincr = thread->num_cores * 4;
+		DWORD fracstep = _iscale * thread->num_cores;
+		DWORD frac = _texturefrac + _iscale * skipped;
+		do
+		{
+			*dest = _source[((fixed_t)frac) >> FRACBITS];
+			dest += dincr;
+			frac += fracstep;
+		} while (--count);
+	}
+};
+
+class FillColumnHorizPalCommand : public DrawerCommand
+{
+	int _count;
+	BYTE _color;
+	int _x;
+	int _yl;
+
+public:
+	FillColumnHorizPalCommand()
+	{
+		_count = dc_count;
+		_color = dc_color;
+		_x = dc_x;
+		_yl = dc_yl;
+	}
+
+	void Execute(DrawerThread *thread) override
+	{
+		int count = thread->count_for_thread(_yl, _count);
+		if (count <= 0)
+			return;
+
+		BYTE *dest = &thread->dc_temp[(_x & 3) + 4 * (_yl + thread->skipped_by_thread(_yl))];
+		int dincr = thread->num_cores * 4;
+		do
+		{
+			*dest = _color;
+			dest += dincr;
+		} while (--count);
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+void R_DrawColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawColumnPalCommand<false>>();
+}
+
+void R_FillColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillColumnPalCommand>();
+}
+
+void R_FillAddColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillBlendColumnPalCommand<PalBlendAdd>>();
+}
+
+void R_FillAddClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillBlendColumnPalCommand<PalBlendAddClamp>>();
+}
+
+void R_FillSubClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillBlendColumnPalCommand<PalBlendSubClamp>>();
+}
+
+void R_FillRevSubClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillBlendColumnPalCommand<PalBlendRevSubClamp>>();
+}
+
+void R_DrawAddColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendAdd, false>>();
+}
+
+void R_DrawTranslatedColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawColumnPalCommand<true>>();
+}
+
+void R_DrawTlatedAddColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendAdd, true>>();
+}
+
+void R_DrawShadedColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawShadedColumnPalCommand>();
+}
+
+void R_DrawAddClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendAddClamp, false>>();
+}
+
+void R_DrawAddClampTranslatedColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendAddClamp, true>>();
+}
+
+void R_DrawSubClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendSubClamp, false>>();
+}
+
+void R_DrawSubClampTranslatedColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendSubClamp, true>>();
+}
+
+void R_DrawRevSubClampColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendRevSubClamp, false>>();
+}
+
+void R_DrawRevSubClampTranslatedColumnP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendColumnPalCommand<PalBlendRevSubClamp, true>>();
+}
+
+void R_DrawSpanP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawSpanPalCommand<false>>();
+}
+
+void R_DrawSpanMaskedP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawSpanPalCommand<true>>();
+}
+
+void R_DrawSpanTranslucentP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendSpanPalCommand<PalBlendAdd, false>>();
+}
+
+void R_DrawSpanMaskedTranslucentP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendSpanPalCommand<PalBlendAdd, true>>();
+}
+
+void R_DrawSpanAddClampP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendSpanPalCommand<PalBlendAddClamp, false>>();
+}
+
+void R_DrawSpanMaskedAddClampP_MT()
+{
+	DrawerCommandQueue::QueueCommand<DrawBlendSpanPalCommand<PalBlendAddClamp, true>>();
+}
+
+void R_FillSpanP_MT()
+{
+	DrawerCommandQueue::QueueCommand<FillSpanPalCommand>(ds_y, ds_x1, ds_x2);
+}
+
+void R_MapColoredPlaneP_MT(int y, int x1)
+{
+	DrawerCommandQueue::QueueCommand<FillSpanPalCommand>(y, x1, (int)spanend[y]);
+}
+
+DWORD vlinec1_mt()
+{
+	DrawerCommandQueue::QueueCommand<Vline1PalCommand<false>>(vlinebits);
+	return (DWORD)dc_texturefrac + (DWORD)dc_iscale * dc_count;
+}
+
+void vlinec4_mt()
+{
+	DrawerCommandQueue::QueueCommand<Vline4PalCommand<false>>(vlinebits);
+	for (int i = 0; i < 4; i++)
+		vplce[i] += vince[i] * dc_count;
+}
+
+DWORD mvlinec1_mt()
+{
+	DrawerCommandQueue::QueueCommand<Vline1PalCommand<true>>(mvlinebits);
+	return (DWORD)dc_texturefrac + (DWORD)dc_iscale * dc_count;
+}
+
+void mvlinec4_mt()
+{
+	DrawerCommandQueue::QueueCommand<Vline4PalCommand<true>>(mvlinebits);
+	for (int i = 0; i < 4; i++)
+		vplce[i] += vince[i] * dc_count;
+}
+
+template<typename BlendMode>
+static fixed_t queue_tmvline1()
+{
+	DrawerCommandQueue::QueueCommand<Tmvline1PalCommand<BlendMode>>();
+	return (fixed_t)((DWORD)dc_texturefrac + (DWORD)dc_iscale * dc_count);
+}
+
+template<typename BlendMode>
+static void queue_tmvline4()
+{
+	DrawerCommandQueue::QueueCommand<Tmvline4PalCommand<BlendMode>>();
+	for (int i = 0; i < 4; i++)
+		vplce[i] += vince[i] * dc_count;
+}
+
+fixed_t tmvline1_add_mt() { return queue_tmvline1<PalBlendAdd>(); }
+void tmvline4_add_mt() { queue_tmvline4<PalBlendAdd>(); }
+fixed_t tmvline1_addclamp_mt() { return queue_tmvline1<PalBlendAddClamp>(); }
+void tmvline4_addclamp_mt() { queue_tmvline4<PalBlendAddClamp>(); }
+fixed_t tmvline1_subclamp_mt() { return queue_tmvline1<PalBlendSubClamp>(); }
+void tmvline4_subclamp_mt() { queue_tmvline4<PalBlendSubClamp>(); }
+fixed_t tmvline1_revsubclamp_mt() { return queue_tmvline1<PalBlendRevSubClamp>(); }
+void tmvline4_revsubclamp_mt() { queue_tmvline4<PalBlendRevSubClamp>(); }
+
+// Stretches a column into the temporary buffer of each thread. The span
+// bookkeeping used by rt_draw4cols stays on the main thread.
+void R_DrawColumnHorizP_MT()
+{
+	if (dc_count <= 0)
+		return;
+
+	unsigned int **span = &dc_ctspan[dc_x & 3];
+	(*span)[0] = dc_yl;
+	(*span)[1] = dc_yh;
+	*span += 2;
+
+	DrawerCommandQueue::QueueCommand<DrawColumnHorizPalCommand>();
+}
+
+void R_FillColumnHorizP_MT()
+{
+	if (dc_count <= 0)
+		return;
+
+	unsigned int **span = &dc_ctspan[dc_x & 3];
+	(*span)[0] = dc_yl;
+	(*span)[1] = dc_yh;
+	*span += 2;
+
+	DrawerCommandQueue::QueueCommand<FillColumnHorizPalCommand>();
+}
+
+void rt_copy1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtCopyPalCommand<1>>(hx, sx, yl, yh);
+}
+
+void rt_copy4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtCopyPalCommand<4>>(0, sx, yl, yh);
+}
+
+void rt_map1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtMapPalCommand<1>>(hx, sx, yl, yh);
+}
+
+void rt_map4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtMapPalCommand<4>>(0, sx, yl, yh);
+}
+
+void rt_shaded1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtShadedPalCommand<1>>(hx, sx, yl, yh);
+}
+
+void rt_shaded4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtShadedPalCommand<4>>(0, sx, yl, yh);
+}
+
+void rt_add1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendAdd, 1>>(hx, sx, yl, yh);
+}
+
+void rt_add4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendAdd, 4>>(0, sx, yl, yh);
+}
+
+void rt_addclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendAddClamp, 1>>(hx, sx, yl, yh);
+}
+
+void rt_addclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendAddClamp, 4>>(0, sx, yl, yh);
+}
+
+void rt_subclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendSubClamp, 1>>(hx, sx, yl, yh);
+}
+
+void rt_subclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendSubClamp, 4>>(0, sx, yl, yh);
+}
+
+void rt_revsubclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendRevSubClamp, 1>>(hx, sx, yl, yh);
+}
+
+void rt_revsubclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtBlendPalCommand<PalBlendRevSubClamp, 4>>(0, sx, yl, yh);
+}
+
+void rt_tlate1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, hx, 1, yl, yh);
+	rt_map1col_mt(hx, sx, yl, yh);
+}
+
+void rt_tlate4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, 0, 4, yl, yh);
+	rt_map4cols_mt(sx, yl, yh);
+}
+
+void rt_tlateadd1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, hx, 1, yl, yh);
+	rt_add1col_mt(hx, sx, yl, yh);
+}
+
+void rt_tlateadd4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, 0, 4, yl, yh);
+	rt_add4cols_mt(sx, yl, yh);
+}
+
+void rt_tlateaddclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, hx, 1, yl, yh);
+	rt_addclamp1col_mt(hx, sx, yl, yh);
+}
+
+void rt_tlateaddclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, 0, 4, yl, yh);
+	rt_addclamp4cols_mt(sx, yl, yh);
+}
+
+void rt_tlatesubclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, hx, 1, yl, yh);
+	rt_subclamp1col_mt(hx, sx, yl, yh);
+}
+
+void rt_tlatesubclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, 0, 4, yl, yh);
+	rt_subclamp4cols_mt(sx, yl, yh);
+}
+
+void rt_tlaterevsubclamp1col_mt(int hx, int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, hx, 1, yl, yh);
+	rt_revsubclamp1col_mt(hx, sx, yl, yh);
+}
+
+void rt_tlaterevsubclamp4cols_mt(int sx, int yl, int yh)
+{
+	DrawerCommandQueue::QueueCommand<RtTranslatePalCommand>(dc_translation, 0, 4, yl, yh);
+	rt_revsubclamp4cols_mt(sx, yl, yh);
+}
+
+void rt_initcols_mt(BYTE *buffer)
+{
+	for (int y = 3; y >= 0; y--)
+		horizspan[y] = dc_ctspan[y] = &dc_tspans[y][0];
+
+	DrawerCommandQueue::QueueCommand<RtInitColsPalCommand>(buffer);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Drawers that are not split into commands:
+//
+// The fuzz drawer reads the rows above and below the pixel it writes and
+// carries fuzzpos from one column to the next, and the others address the
+// frame buffer on their own. They wait for the queue and then run inline.
+
+static void (*InlineFuzzColumn)();
+static void (*InlineFogBoundary)(int x1, int x2, short *uclip, short *dclip);
+static void (*InlineMapTiltedPlane)(int y, int x1);
+static void (*InlineDrawParticle)(vissprite_t *);
+static void (*InlineDrawSlab)(int dx, fixed_t v, int dy, fixed_t vi, const BYTE *vptr, BYTE *p);
+
+void R_DrawFuzzColumnP_MT()
+{
+	DrawerCommandQueue::WaitForWorkers();
+	InlineFuzzColumn();
+}
+
+static void R_DrawFogBoundaryP_MT(int x1, int x2, short *uclip, short *dclip)
+{
+	DrawerCommandQueue::WaitForWorkers();
+	InlineFogBoundary(x1, x2, uclip, dclip);
+}
+
+static void R_MapTiltedPlaneP_MT(int y, int x1)
+{
+	DrawerCommandQueue::WaitForWorkers();
+	InlineMapTiltedPlane(y, x1);
+}
+
+static void R_DrawParticleP_MT(vissprite_t *vis)
+{
+	DrawerCommandQueue::WaitForWorkers();
+	InlineDrawParticle(vis);
+}
+
+static void R_DrawSlabP_MT(int dx, fixed_t v, int dy, fixed_t vi, const BYTE *vptr, BYTE *p)
+{
+	DrawerCommandQueue::WaitForWorkers();
+	InlineDrawSlab(dx, v, dy, vi, vptr, p);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void R_InitQueuedPalDrawers()
+{
+	InlineFuzzColumn			= R_DrawFuzzColumn;
+	InlineFogBoundary			= R_DrawFogBoundary;
+	InlineMapTiltedPlane		= R_MapTiltedPlane;
+	InlineDrawParticle			= R_DrawParticle;
+	InlineDrawSlab				= R_DrawSlab;
+
+	R_DrawColumnHoriz			= R_DrawColumnHorizP_MT;
+	R_DrawColumn				= R_DrawColumnP_MT;
+	R_DrawFuzzColumn			= R_DrawFuzzColumnP_MT;
+	R_DrawTranslatedColumn		= R_DrawTranslatedColumnP_MT;
+	R_DrawShadedColumn			= R_DrawShadedColumnP_MT;
+	R_DrawSpan					= R_DrawSpanP_MT;
+	R_DrawSpanMasked			= R_DrawSpanMaskedP_MT;
+	R_DrawSpanTranslucent		= R_DrawSpanTranslucentP_MT;
+	R_DrawSpanMaskedTranslucent = R_DrawSpanMaskedTranslucentP_MT;
+	R_DrawSpanAddClamp			= R_DrawSpanAddClampP_MT;
+	R_DrawSpanMaskedAddClamp	= R_DrawSpanMaskedAddClampP_MT;
+	R_FillColumn				= R_FillColumnP_MT;
+	R_FillAddColumn				= R_FillAddColumnP_MT;
+	R_FillAddClampColumn		= R_FillAddClampColumnP_MT;
+	R_FillSubClampColumn		= R_FillSubClampColumnP_MT;
+	R_FillRevSubClampColumn		= R_FillRevSubClampColumnP_MT;
+	R_DrawAddColumn				= R_DrawAddColumnP_MT;
+	R_DrawTlatedAddColumn		= R_DrawTlatedAddColumnP_MT;
+	R_DrawAddClampColumn		= R_DrawAddClampColumnP_MT;
+	R_DrawAddClampTranslatedColumn = R_DrawAddClampTranslatedColumnP_MT;
+	R_DrawSubClampColumn		= R_DrawSubClampColumnP_MT;
+	R_DrawSubClampTranslatedColumn = R_DrawSubClampTranslatedColumnP_MT;
+	R_DrawRevSubClampColumn		= R_DrawRevSubClampColumnP_MT;
+	R_DrawRevSubClampTranslatedColumn = R_DrawRevSubClampTranslatedColumnP_MT;
+	R_FillSpan					= R_FillSpanP_MT;
+	R_FillColumnHoriz			= R_FillColumnHorizP_MT;
+
+	R_DrawFogBoundary			= R_DrawFogBoundaryP_MT;
+	R_MapTiltedPlane			= R_MapTiltedPlaneP_MT;
+	R_MapColoredPlane			= R_MapColoredPlaneP_MT;
+	R_DrawParticle				= R_DrawParticleP_MT;
+	R_DrawSlab					= R_DrawSlabP_MT;
+
+	tmvline1_add				= tmvline1_add_mt;
+	tmvline4_add				= tmvline4_add_mt;
+	tmvline1_addclamp			= tmvline1_addclamp_mt;
+	tmvline4_addclamp			= tmvline4_addclamp_mt;
+	tmvline1_subclamp			= tmvline1_subclamp_mt;
+	tmvline4_subclamp			= tmvline4_subclamp_mt;
+	tmvline1_revsubclamp		= tmvline1_revsubclamp_mt;
+	tmvline4_revsubclamp		= tmvline4_revsubclamp_mt;
+
+	rt_copy1col					= rt_copy1col_mt;
+	rt_copy4cols				= rt_copy4cols_mt;
+	rt_map1col					= rt_map1col_mt;
+	rt_map4cols					= rt_map4cols_mt;
+	rt_shaded1col				= rt_shaded1col_mt;
+	rt_shaded4cols				= rt_shaded4cols_mt;
+	rt_add1col					= rt_add1col_mt;
+	rt_add4cols					= rt_add4cols_mt;
+	rt_addclamp1col				= rt_addclamp1col_mt;
+	rt_addclamp4cols			= rt_addclamp4cols_mt;
+	rt_subclamp1col				= rt_subclamp1col_mt;
+	rt_revsubclamp1col			= rt_revsubclamp1col_mt;
+	rt_tlate1col				= rt_tlate1col_mt;
+	rt_tlateadd1col				= rt_tlateadd1col_mt;
+	rt_tlateaddclamp1col		= rt_tlateaddclamp1col_mt;
+	rt_tlatesubclamp1col		= rt_tlatesubclamp1col_mt;
+	rt_tlaterevsubclamp1col		= rt_tlaterevsubclamp1col_mt;
+	rt_subclamp4cols			= rt_subclamp4cols_mt;
+	rt_revsubclamp4cols			= rt_revsubclamp4cols_mt;
+	rt_tlate4cols				= rt_tlate4cols_mt;
+	rt_tlateadd4cols			= rt_tlateadd4cols_mt;
+	rt_tlateaddclamp4cols		= rt_tlateaddclamp4cols_mt;
+	rt_tlatesubclamp4cols		= rt_tlatesubclamp4cols_mt;
+	rt_tlaterevsubclamp4cols	= rt_tlaterevsubclamp4cols_mt;
+	rt_initcols					= rt_initcols_mt;
+
+	dovline1					= vlinec1_mt;
+	doprevline1					= vlinec1_mt;
+	domvline1					= mvlinec1_mt;
+	dovline4					= vlinec4_mt;
+	domvline4					= mvlinec4_mt;
+}
@@ -0,0 +1,102 @@
+// Emacs style mode select	 -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//		Paletted drawers that run on the drawer worker threads.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __R_DRAW_PAL__
+#define __R_DRAW_PAL__
+
+#include "r_draw.h"
+
+// Redirects the paletted drawer pointers to their queued versions.
+// Called by R_InitColumnDrawers after it has selected the inline
+// paletted drawers, when r_multithreaded is on.
+void R_InitQueuedPalDrawers();
+
+void R_DrawColumnP_MT();
+void R_FillColumnP_MT();
+void R_FillAddColumnP_MT();
+void R_FillAddClampColumnP_MT();
+void R_FillSubClampColumnP_MT();
+void R_FillRevSubClampColumnP_MT();
+void R_DrawFuzzColumnP_MT();
+void R_DrawAddColumnP_MT();
+void R_DrawTranslatedColumnP_MT();
+void R_DrawTlatedAddColumnP_MT();
+void R_DrawShadedColumnP_MT();
+void R_DrawAddClampColumnP_MT();
+void R_DrawAddClampTranslatedColumnP_MT();
+void R_DrawSubClampColumnP_MT();
+void R_DrawSubClampTranslatedColumnP_MT();
+void R_DrawRevSubClampColumnP_MT();
+void R_DrawRevSubClampTranslatedColumnP_MT();
+
+void R_DrawSpanP_MT();
+void R_DrawSpanMaskedP_MT();
+void R_DrawSpanTranslucentP_MT();
+void R_DrawSpanMaskedTranslucentP_MT();
+void R_DrawSpanAddClampP_MT();
+void R_DrawSpanMaskedAddClampP_MT();
+void R_FillSpanP_MT();
+void R_MapColoredPlaneP_MT(int y, int x1);
+
+DWORD vlinec1_mt();
+void vlinec4_mt();
+DWORD mvlinec1_mt();
+void mvlinec4_mt();
+fixed_t tmvline1_add_mt();
+void tmvline4_add_mt();
+fixed_t tmvline1_addclamp_mt();
+void tmvline4_addclamp_mt();
+fixed_t tmvline1_subclamp_mt();
+void tmvline4_subclamp_mt();
+fixed_t tmvline1_revsubclamp_mt();
+void tmvline4_revsubclamp_mt();
+
+void R_DrawColumnHorizP_MT();
+void R_FillColumnHorizP_MT();
+
+void rt_copy1col_mt(int hx, int sx, int yl, int yh);
+void rt_copy4cols_mt(int sx, int yl, int yh);
+void rt_map1col_mt(int hx, int sx, int yl, int yh);
+void rt_map4cols_mt(int sx, int yl, int yh);
+void rt_shaded1col_mt(int hx, int sx, int yl, int yh);
+void rt_shaded4cols_mt(int sx, int yl, int yh);
+void rt_add1col_mt(int hx, int sx, int yl, int yh);
+void rt_add4cols_mt(int sx, int yl, int yh);
+void rt_addclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_addclamp4cols_mt(int sx, int yl, int yh);
+void rt_subclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_subclamp4cols_mt(int sx, int yl, int yh);
+void rt_revsubclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_revsubclamp4cols_mt(int sx, int yl, int yh);
+void rt_tlate1col_mt(int hx, int sx, int yl, int yh);
+void rt_tlate4cols_mt(int sx, int yl, int yh);
+void rt_tlateadd1col_mt(int hx, int sx, int yl, int yh);
+void rt_tlateadd4cols_mt(int sx, int yl, int yh);
+void rt_tlateaddclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_tlateaddclamp4cols_mt(int sx, int yl, int yh);
+void rt_tlatesubclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_tlatesubclamp4cols_mt(int sx, int yl, int yh);
+void rt_tlaterevsubclamp1col_mt(int hx, int sx, int yl, int yh);
+void rt_tlaterevsubclamp4cols_mt(int sx, int yl, int yh);
+void rt_initcols_mt(BYTE *buffer);
+
+#endif
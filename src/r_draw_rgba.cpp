@@ -42,6 +42,7 @@
 #include "gi.h"
 #include "stats.h"
 #include "x86.h"
+#include "profiler.h"
 #ifndef NO_SSE
 #include <emmintrin.h>
 #include <immintrin.h>
@@ -54,7 +55,11 @@ extern float rw_lightstep;
 extern int wallshade;
 
 // Use multiple threads when drawing
-CVAR(Bool, r_multithreaded, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CUSTOM_CVAR(Bool, r_multithreaded, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
+{
+	// The paletted drawers only go through the command queue while this is on.
+	R_InitColumnDrawers();
+}
 
 // Use linear filtering when scaling up
 CVAR(Bool, r_magfilter, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
@@ -195,27 +200,33 @@ void DrawerCommandQueue::Finish()
 
 	// Do one thread ourselves:
 
-	DrawerThread thread;
+	// The main thread keeps its own worker data between batches, as the rt_*
+	// drawers may leave their temporary buffer half filled across a flush.
+	DrawerThread &thread = queue->main_thread;
 	thread.core = 0;
 	thread.num_cores = queue->threads.size() + 1;
 
-	for (int pass = 0; pass < queue->num_passes; pass++)
 	{
-		thread.pass_start_y = pass * queue->rows_in_pass;
-		thread.pass_end_y = (pass + 1) * queue->rows_in_pass;
-		if (pass + 1 == queue->num_passes)
-			thread.pass_end_y = MAX(thread.pass_end_y, MAXHEIGHT);
-
-		size_t size = queue->active_commands.size();
-		for (size_t i = 0; i < size; i++)
+		FProfileScope profile("Drawers");
+		for (int pass = 0; pass < queue->num_passes; pass++)
 		{
-			auto &command = queue->active_commands[i];
-			command->Execute(&thread);
+			thread.pass_start_y = pass * queue->rows_in_pass;
+			thread.pass_end_y = (pass + 1) * queue->rows_in_pass;
+			if (pass + 1 == queue->num_passes)
+				thread.pass_end_y = MAX(thread.pass_end_y, MAXHEIGHT);
+
+			size_t size = queue->active_commands.size();
+			for (size_t i = 0; i < size; i++)
+			{
+				auto &command = queue->active_commands[i];
+				command->Execute(&thread);
+			}
 		}
 	}
 
 	// Wait for everyone to finish:
 
+	FProfileScope profilewait("Wait for drawers");
 	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
 	queue->end_condition.wait(end_lock, [&]() { return queue->finished_threads == queue->threads.size(); });
 
@@ -247,6 +258,10 @@ void DrawerCommandQueue::StartThreads()
 		thread->num_cores = num_threads;
 		thread->thread = std::thread([=]()
 		{
+			FString name;
+			name.Format("Drawer %d", thread->core);
+			Prof_SetThreadName(name);
+
 			int run_id = 0;
 			while (true)
 			{
@@ -259,18 +274,21 @@ void DrawerCommandQueue::StartThreads()
 				start_lock.unlock();
 
 				// Do the work:
-				for (int pass = 0; pass < queue->num_passes; pass++)
 				{
-					thread->pass_start_y = pass * queue->rows_in_pass;
-					thread->pass_end_y = (pass + 1) * queue->rows_in_pass;
-					if (pass + 1 == queue->num_passes)
-						thread->pass_end_y = MAX(thread->pass_end_y, MAXHEIGHT);
-
-					size_t size = queue->active_commands.size();
-					for (size_t i = 0; i < size; i++)
+					FProfileScope profile("Drawers");
+					for (int pass = 0; pass < queue->num_passes; pass++)
 					{
-						auto &command = queue->active_commands[i];
-						command->Execute(thread);
+						thread->pass_start_y = pass * queue->rows_in_pass;
+						thread->pass_end_y = (pass + 1) * queue->rows_in_pass;
+						if (pass + 1 == queue->num_passes)
+							thread->pass_end_y = MAX(thread->pass_end_y, MAXHEIGHT);
+
+						size_t size = queue->active_commands.size();
+						for (size_t i = 0; i < size; i++)
+						{
+							auto &command = queue->active_commands[i];
+							command->Execute(thread);
+						}
 					}
 				}
 
@@ -2596,6 +2614,73 @@ void ApplySpecialColormapRGBACommand::Execute(DrawerThread *thread)
 }
 #endif
 
+CopyWithGammaBgraCommand::CopyWithGammaBgraCommand(const BYTE *src, int srcpitch, void *dest, int destpitch, int width, int height, const BYTE *gammared, const BYTE *gammagreen, const BYTE *gammablue, PalEntry flash, int flash_amount)
+	: src(src), srcpitch(srcpitch), dest((BYTE*)dest), destpitch(destpitch), width(width), height(height), flash(flash), flash_amount(flash_amount)
+{
+	gammatables[0] = gammared;
+	gammatables[1] = gammagreen;
+	gammatables[2] = gammablue;
+}
+
+void CopyWithGammaBgraCommand::Execute(DrawerThread *thread)
+{
+	int y = thread->skipped_by_thread(0);
+	int count = thread->count_for_thread(0, height);
+
+	if (flash_amount > 0)
+	{
+		uint16_t inv_flash_amount = 256 - flash_amount;
+		uint16_t flash_red = flash.r * flash_amount;
+		uint16_t flash_green = flash.g * flash_amount;
+		uint16_t flash_blue = flash.b * flash_amount;
+
+		while (count > 0)
+		{
+			BYTE *d = dest + y * destpitch;
+			const BYTE *s = src + y * srcpitch * 4;
+			for (int x = 0; x < width; x++)
+			{
+				uint16_t fg_red = s[2];
+				uint16_t fg_green = s[1];
+				uint16_t fg_blue = s[0];
+				uint16_t red = (fg_red * inv_flash_amount + flash_red) >> 8;
+				uint16_t green = (fg_green * inv_flash_amount + flash_green) >> 8;
+				uint16_t blue = (fg_blue * inv_flash_amount + flash_blue) >> 8;
+
+				d[0] = gammatables[2][blue];
+				d[1] = gammatables[1][green];
+				d[2] = gammatables[0][red];
+				d[3] = 0xff;
+
+				d += 4;
+				s += 4;
+			}
+			y += thread->num_cores;
+			count--;
+		}
+	}
+	else
+	{
+		while (count > 0)
+		{
+			BYTE *d = dest + y * destpitch;
+			const BYTE *s = src + y * srcpitch * 4;
+			for (int x = 0; x < width; x++)
+			{
+				d[0] = gammatables[2][s[0]];
+				d[1] = gammatables[1][s[1]];
+				d[2] = gammatables[0][s[2]];
+				d[3] = 0xff;
+
+				d += 4;
+				s += 4;
+			}
+			y += thread->num_cores;
+			count--;
+		}
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 void R_BeginDrawerCommands()
@@ -149,6 +149,10 @@ public:
 	uint32_t dc_temp_rgbabuff_rgba[MAXHEIGHT * 4];
 	uint32_t *dc_temp_rgba;
 
+	// Temporary buffer for the paletted rt_* drawers
+	BYTE dc_temp_buff[MAXHEIGHT * 4];
+	BYTE *dc_temp;
+
 	// Checks if a line is rendered by this thread
 	bool line_skipped_by_thread(int line)
 	{
@@ -188,9 +192,12 @@ protected:
 public:
 	DrawerCommand()
 	{
-		_dest_y = static_cast<int>((dc_dest - dc_destorg) / (dc_pitch * 4));
+		int pixelsize = r_swtruecolor ? 4 : 1;
+		_dest_y = static_cast<int>((dc_dest - dc_destorg) / (dc_pitch * pixelsize));
 	}
 
+	virtual ~DrawerCommand() { }
+
 	virtual void Execute(DrawerThread *thread) = 0;
 };
 
@@ -220,6 +227,7 @@ class DrawerCommandQueue
 
 	int threaded_render = 0;
 	DrawerThread single_core_thread;
+	DrawerThread main_thread;
 	int num_passes = 1;
 	int rows_in_pass = MAXHEIGHT;
 
@@ -293,6 +301,24 @@ public:
 	void Execute(DrawerThread *thread) override;
 };
 
+// Copies a finished true color frame to the video output while applying gamma and flash
+class CopyWithGammaBgraCommand : public DrawerCommand
+{
+	const BYTE *src;
+	int srcpitch;
+	BYTE *dest;
+	int destpitch;
+	int width;
+	int height;
+	const BYTE *gammatables[3];
+	PalEntry flash;
+	int flash_amount;
+
+public:
+	CopyWithGammaBgraCommand(const BYTE *src, int srcpitch, void *dest, int destpitch, int width, int height, const BYTE *gammared, const BYTE *gammagreen, const BYTE *gammablue, PalEntry flash, int flash_amount);
+	void Execute(DrawerThread *thread) override;
+};
+
 template<typename CommandType, typename BlendMode>
 class DrawerBlendCommand : public CommandType
 {
@@ -38,6 +38,7 @@
 #include "r_plane.h"
 #include "r_bsp.h"
 #include "r_segs.h"
+#include "profiler.h"
 #include "r_3dfloors.h"
 #include "r_sky.h"
 #include "r_draw_rgba.h"
@@ -619,6 +620,100 @@ void R_SetupFreelook()
 	}
 }
 
+//==========================================================================
+//
+// FPortalRenderContext :: SaveView
+//
+//==========================================================================
+
+static TDeletingArray<FPortalRenderContext *> PortalContexts;
+static unsigned int PortalContextDepth;
+static int PortalCount;
+static double PortalMaxMS;
+static cycle_t PortalCycles;
+
+void FPortalRenderContext::SaveView()
+{
+	ViewPos = ::ViewPos;
+	ViewAngle = ::ViewAngle;
+	ViewPath[0] = ::ViewPath[0];
+	ViewPath[1] = ::ViewPath[1];
+	ExtraLight = extralight;
+	Visibility = R_GetVisibility();
+	Camera = camera;
+	CameraInvisible = camera ? camera->renderflags & RF_INVISIBLE : ActorRenderFlags::FromInt(0);
+	ViewSector = viewsector;
+	MirrorFlags = ::MirrorFlags;
+	Portal = CurrentPortal;
+}
+
+//==========================================================================
+//
+// FPortalRenderContext :: RestoreView
+//
+//==========================================================================
+
+void FPortalRenderContext::RestoreView()
+{
+	::ViewPos = ViewPos;
+	::ViewAngle = ViewAngle;
+	::ViewPath[0] = ViewPath[0];
+	::ViewPath[1] = ViewPath[1];
+	extralight = ExtraLight;
+	R_SetVisibility(Visibility);
+	camera = Camera;
+	viewsector = ViewSector;
+	::MirrorFlags = MirrorFlags;
+	CurrentPortal = Portal;
+	R_SetViewAngle();
+}
+
+//==========================================================================
+//
+// R_PushPortalContext
+//
+// Contexts are reused in stack order. Since they never move, a context
+// stays valid while deeper portals push their own.
+//
+//==========================================================================
+
+FPortalRenderContext *R_PushPortalContext()
+{
+	if (PortalContextDepth == PortalContexts.Size())
+	{
+		PortalContexts.Push(new FPortalRenderContext);
+	}
+	FPortalRenderContext *context = PortalContexts[PortalContextDepth++];
+	context->Cycles.Reset();
+	return context;
+}
+
+//==========================================================================
+//
+// R_TopPortalContext
+//
+//==========================================================================
+
+FPortalRenderContext *R_TopPortalContext()
+{
+	assert(PortalContextDepth > 0);
+	return PortalContexts[PortalContextDepth - 1];
+}
+
+//==========================================================================
+//
+// R_PopPortalContext
+//
+//==========================================================================
+
+void R_PopPortalContext()
+{
+	FPortalRenderContext *context = R_TopPortalContext();
+	PortalContextDepth--;
+	PortalCount++;
+	PortalMaxMS = MAX(PortalMaxMS, context->Cycles.TimeMS());
+}
+
 //==========================================================================
 //
 // R_EnterPortal
@@ -641,6 +736,7 @@ void R_HighlightPortal (PortalDrawseg* pds)
 
 	BYTE color = (BYTE)BestColor((DWORD *)GPalette.BaseColors, 255, 0, 0, 0, 255);
 
+	DrawerCommandQueue::WaitForWorkers();
 	BYTE* pixels = RenderTarget->GetBuffer();
 	// top edge
 	for (int x = pds->x1; x < pds->x2; x++)
@@ -673,11 +769,14 @@ void R_HighlightPortal (PortalDrawseg* pds)
 
 void R_EnterPortal (PortalDrawseg* pds, int depth)
 {
+	FProfileScope profile("Portal");
+
 	// [ZZ] check depth. fill portal with black if it's exceeding the visual recursion limit, and continue like nothing happened.
 	if (depth >= r_portal_recursions)
 	{
 		BYTE color = (BYTE)BestColor((DWORD *)GPalette.BaseColors, 0, 0, 0, 0, 255);
 		int spacing = RenderTarget->GetPitch();
+		DrawerCommandQueue::WaitForWorkers();
 		for (int x = pds->x1; x < pds->x2; x++)
 		{
 			if (x < 0 || x >= RenderTarget->GetWidth())
@@ -715,10 +814,12 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 		return;
 	}
 
+	FPortalRenderContext *saved = R_PushPortalContext();
+	saved->Cycles.Clock();
+	saved->SaveView();
+
 	DAngle startang = ViewAngle;
 	DVector3 startpos = ViewPos;
-	DVector3 savedpath[2] = { ViewPath[0], ViewPath[1] };
-	ActorRenderFlags savedvisibility = camera? camera->renderflags & RF_INVISIBLE : ActorRenderFlags::FromInt(0);
 
 	CurrentPortalUniq++;
 
@@ -781,16 +882,10 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 		}
 	}
 
-	ViewSin = ViewAngle.Sin();
-	ViewCos = ViewAngle.Cos();
-
-	ViewTanSin = FocalTangent * ViewSin;
-	ViewTanCos = FocalTangent * ViewCos;
-
+	R_SetViewAngle();
 	R_CopyStackedViewParameters();
 
 	validcount++;
-	PortalDrawseg* prevpds = CurrentPortal;
 	CurrentPortal = pds;
 
 	R_ClearPlanes (false);
@@ -800,7 +895,6 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 	WindowRight = pds->x2;
 	
 	// RF_XFLIP should be removed before calling the root function
-	int prevmf = MirrorFlags;
 	if (pds->mirror)
 	{
 		if (MirrorFlags & RF_XFLIP)
@@ -817,9 +911,9 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 	memcpy (floorclip + pds->x1, &pds->floorclip[0], pds->len*sizeof(*floorclip));
 
 	InSubsector = NULL;
-	R_RenderBSPNode (nodes + numnodes - 1);
+	R_RenderBSP ();
 	R_3D_ResetClip(); // reset clips (floor/ceiling)
-	if (!savedvisibility && camera) camera->renderflags &= ~RF_INVISIBLE;
+	if (!saved->CameraInvisible && camera) camera->renderflags &= ~RF_INVISIBLE;
 
 	PlaneCycles.Clock();
 	R_DrawPlanes ();
@@ -833,7 +927,7 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 	unsigned int portalsAtEnd = WallPortals.Size ();
 	for (; portalsAtStart < portalsAtEnd; portalsAtStart++)
 	{
-		R_EnterPortal (&WallPortals[portalsAtStart], depth + 1);
+		R_EnterPortal (WallPortals[portalsAtStart], depth + 1);
 	}
 	int prevuniq2 = CurrentPortalUniq;
 	CurrentPortalUniq = prevuniq;
@@ -853,12 +947,9 @@ void R_EnterPortal (PortalDrawseg* pds, int depth)
 	if (r_highlight_portals)
 		R_HighlightPortal(pds);
 
-	CurrentPortal = prevpds;
-	MirrorFlags = prevmf;
-	ViewAngle = startang;
-	ViewPos = startpos;
-	ViewPath[0] = savedpath[0];
-	ViewPath[1] = savedpath[1];
+	saved->RestoreView();
+	saved->Cycles.Unclock();
+	R_PopPortalContext();
 }
 
 //==========================================================================
@@ -912,10 +1003,15 @@ void R_SetupBuffer (bool inview)
 
 void R_RenderActorView (AActor *actor, bool dontmaplines)
 {
+	FProfileScope profile("Render view");
+
 	WallCycles.Reset();
 	PlaneCycles.Reset();
 	MaskedCycles.Reset();
 	WallScanCycles.Reset();
+	PortalCycles.Reset();
+	PortalCount = 0;
+	PortalMaxMS = 0;
 
 	fakeActive = 0; // kg3D - reset fake floor indicator
 	R_3D_ResetClip(); // reset clips (floor/ceiling)
@@ -973,7 +1069,10 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 	// Link the polyobjects right before drawing the scene to reduce the amounts of calls to this function
 	PO_LinkToSubsectors();
 	InSubsector = NULL;
-	R_RenderBSPNode (nodes + numnodes - 1);	// The head node is the last node output.
+	{
+		FProfileScope profilebsp("BSP and walls");
+		R_RenderBSP ();
+	}
 	R_3D_ResetClip(); // reset clips (floor/ceiling)
 	camera->renderflags = savedflags;
 	WallCycles.Unclock();
@@ -984,16 +1083,20 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 	{
 		PlaneCycles.Clock();
 		R_DrawPlanes ();
+		PortalCycles.Clock();
 		R_DrawPortals ();
+		PortalCycles.Unclock();
 		PlaneCycles.Unclock();
 
 		// [RH] Walk through mirrors
 		// [ZZ] Merged with portals
+		PortalCycles.Clock();
 		size_t lastportal = WallPortals.Size();
 		for (unsigned int i = 0; i < lastportal; i++)
 		{
-			R_EnterPortal(&WallPortals[i], 0);
+			R_EnterPortal(WallPortals[i], 0);
 		}
+		PortalCycles.Unclock();
 
 		CurrentPortal = NULL;
 		CurrentPortalUniq = 0;
@@ -1007,6 +1110,7 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 		NetUpdate ();
 	}
 	WallPortals.Clear ();
+	R_FinishWallSetupCapture ();
 	interpolator.RestoreInterpolations ();
 
 	// If there is vertical doubling, and the view window is not an even height,
@@ -1113,6 +1217,22 @@ ADD_STAT (fps)
 	return out;
 }
 
+//==========================================================================
+//
+// STAT portals
+//
+// Wall portals and skyboxes drawn this frame, the time spent in all of
+// them and the slowest single one (which includes the portals inside it).
+//
+//==========================================================================
+
+ADD_STAT (portals)
+{
+	FString out;
+	out.Format("portals=%d  contexts=%u  total=%04.1f ms  slowest=%04.1f ms",
+		PortalCount, PortalContexts.Size(), PortalCycles.TimeMS(), PortalMaxMS);
+	return out;
+}
 
 static double f_acc, w_acc,p_acc,m_acc;
 static int acc_c;
@@ -27,6 +27,7 @@
 #include "d_player.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
+#include "stats.h"
 
 
 typedef BYTE lighttable_t;	// This could be wider for >8 bit display.
@@ -152,5 +153,51 @@ extern DAngle stacked_angle;
 
 extern void R_CopyStackedViewParameters();
 
+//==========================================================================
+//
+// Portal render contexts
+//
+// Holds the view state a portal replaces, so it can be put back once the
+// portal is done. Skybox planes also keep the start of their drawsegs and
+// vissprites here until the masked pass. Contexts are pooled and handed
+// out in stack order, so after the first few frames a portal does not
+// allocate anything.
+//
+//==========================================================================
+
+struct visplane_s;
+struct PortalDrawseg;
+
+struct FPortalRenderContext
+{
+	// View
+	DVector3 ViewPos;
+	DAngle ViewAngle;
+	DVector3 ViewPath[2];
+	int ExtraLight;
+	double Visibility;
+	AActor *Camera;
+	ActorRenderFlags CameraInvisible;
+	sector_t *ViewSector;
+	WORD MirrorFlags;
+	PortalDrawseg *Portal;
+
+	// Scene ranges
+	ptrdiff_t FirstDrawseg;
+	ptrdiff_t FirstVissprite;
+	ptrdiff_t LastOpening;
+	size_t FirstInteresting;
+	visplane_s *Plane;
+
+	cycle_t Cycles;		// time spent in this portal, including nested ones
+
+	void SaveView();
+	void RestoreView();
+};
+
+FPortalRenderContext *R_PushPortalContext();
+FPortalRenderContext *R_TopPortalContext();
+void R_PopPortalContext();
+
 
 #endif // __R_MAIN_H__
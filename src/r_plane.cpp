@@ -54,6 +54,7 @@
 #include "g_level.h"
 #include "r_bsp.h"
 #include "r_plane.h"
+#include "profiler.h"
 #include "r_segs.h"
 #include "r_3dfloors.h"
 #include "v_palette.h"
@@ -1061,6 +1062,8 @@ static void R_DrawSkyColumnStripe(int start_x, int y1, int y2, int columns, doub
 	}
 	else
 	{
+		// The paletted sky drawers are not queued
+		DrawerCommandQueue::WaitForWorkers();
 		if (columns == 4)
 			if (!backskytex)
 				R_DrawSingleSkyCol4(solid_top, solid_bottom);
@@ -1296,6 +1299,8 @@ CVAR (Bool, tilt, false, 0);
 
 int R_DrawPlanes ()
 {
+	FProfileScope profile("Planes");
+
 	visplane_t *pl;
 	int i;
 	int vpcount = 0;
@@ -1420,6 +1425,7 @@ void R_DrawSinglePlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 //   2. Clear out the old planes. (They have already been drawn.)
 //   3. Clear a window out of the ClipSegs just large enough for the plane.
 //   4. Pretend the existing vissprites and drawsegs aren't there.
+//      Where they start is kept in a portal render context.
 //   5. Create a drawseg at 0 distance to clip sprites to the visplane. It
 //      doesn't need to be associated with a line in the map, since there
 //      will never be any sprites in front of it.
@@ -1434,12 +1440,6 @@ static int numskyboxes;
 
 void R_DrawPortals ()
 {
-	static TArray<size_t> interestingStack;
-	static TArray<ptrdiff_t> drawsegStack;
-	static TArray<ptrdiff_t> visspriteStack;
-	static TArray<DVector3> viewposStack;
-	static TArray<visplane_t *> visplaneStack;
-
 	numskyboxes = 0;
 
 	if (visplanes[MAXVISPLANES] == NULL)
@@ -1448,17 +1448,14 @@ void R_DrawPortals ()
 	R_3D_EnterSkybox();
 	CurrentPortalInSkybox = true;
 
-	int savedextralight = extralight;
-	DVector3 savedpos = ViewPos;
-	DAngle savedangle = ViewAngle;
-	ptrdiff_t savedvissprite_p = vissprite_p - vissprites;
-	ptrdiff_t savedds_p = ds_p - drawsegs;
-	ptrdiff_t savedlastopening = lastopening;
-	size_t savedinteresting = FirstInterestingDrawseg;
-	double savedvisibility = R_GetVisibility();
-	AActor *savedcamera = camera;
-	sector_t *savedsector = viewsector;
+	FPortalRenderContext saved;
+	saved.SaveView();
+	saved.FirstVissprite = vissprite_p - vissprites;
+	saved.FirstDrawseg = ds_p - drawsegs;
+	saved.LastOpening = lastopening;
+	saved.FirstInteresting = FirstInterestingDrawseg;
 
+	int numcontexts = 0;
 	int i;
 	visplane_t *pl;
 
@@ -1480,6 +1477,11 @@ void R_DrawPortals ()
 
 		numskyboxes++;
 
+		FProfileScope profile("Skybox");
+		FPortalRenderContext *context = R_PushPortalContext();
+		numcontexts++;
+		context->Cycles.Clock();
+
 		FSectorPortal *port = pl->portal;
 		switch (port->mType)
 		{
@@ -1491,7 +1493,7 @@ void R_DrawPortals ()
 			R_SetVisibility(sky->args[0] * 0.25f);
 
 			ViewPos = sky->InterpolatedPosition(r_TicFracF);
-			ViewAngle = savedangle + (sky->PrevAngles.Yaw + deltaangle(sky->PrevAngles.Yaw, sky->Angles.Yaw) * r_TicFracF);
+			ViewAngle = saved.ViewAngle + (sky->PrevAngles.Yaw + deltaangle(sky->PrevAngles.Yaw, sky->Angles.Yaw) * r_TicFracF);
 
 			R_CopyStackedViewParameters();
 			break;
@@ -1517,6 +1519,9 @@ void R_DrawPortals ()
 			*freehead = pl;
 			freehead = &pl->next;
 			numskyboxes--;
+			context->Cycles.Unclock();
+			R_PopPortalContext();
+			numcontexts--;
 			continue;
 		}
 
@@ -1570,67 +1575,63 @@ void R_DrawPortals ()
 		firstdrawseg = ds_p++;
 		FirstInterestingDrawseg = InterestingDrawsegs.Size();
 
-		interestingStack.Push (FirstInterestingDrawseg);
-		ptrdiff_t diffnum = firstdrawseg - drawsegs;
-		drawsegStack.Push (diffnum);
-		diffnum = firstvissprite - vissprites;
-		visspriteStack.Push (diffnum);
-		viewposStack.Push(ViewPos);
-		visplaneStack.Push (pl);
+		context->FirstInteresting = FirstInterestingDrawseg;
+		context->FirstDrawseg = firstdrawseg - drawsegs;
+		context->FirstVissprite = firstvissprite - vissprites;
+		context->ViewPos = ViewPos;
+		context->Plane = pl;
 
 		InSubsector = NULL;
-		R_RenderBSPNode (nodes + numnodes - 1);
+		R_RenderBSP ();
 		R_3D_ResetClip(); // reset clips (floor/ceiling)
 		R_DrawPlanes ();
 
 		port->mFlags &= ~PORTSF_INSKYBOX;
 		if (port->mPartner > 0) sectorPortals[port->mPartner].mFlags &= ~PORTSF_INSKYBOX;
+		context->Cycles.Unclock();
 	}
 
 	// Draw all the masked textures in a second pass, in the reverse order they
 	// were added. This must be done separately from the previous step for the
 	// sake of nested skyboxes.
-	while (interestingStack.Pop (FirstInterestingDrawseg))
+	for (; numcontexts > 0; numcontexts--)
 	{
-		ptrdiff_t pd = 0;
+		FPortalRenderContext *context = R_TopPortalContext();
+		context->Cycles.Clock();
 
-		drawsegStack.Pop (pd);
-		firstdrawseg = drawsegs + pd;
-		visspriteStack.Pop (pd);
-		firstvissprite = vissprites + pd;
+		FirstInterestingDrawseg = context->FirstInteresting;
+		firstdrawseg = drawsegs + context->FirstDrawseg;
+		firstvissprite = vissprites + context->FirstVissprite;
 
 		// Masked textures and planes need the view coordinates restored for proper positioning.
-		viewposStack.Pop(ViewPos);
+		ViewPos = context->ViewPos;
 
 		R_DrawMasked ();
 
 		ds_p = firstdrawseg;
 		vissprite_p = firstvissprite;
 
-		visplaneStack.Pop (pl);
+		pl = context->Plane;
 		if (pl->Alpha > 0 && pl->picnum != skyflatnum)
 		{
 			R_DrawSinglePlane (pl, pl->Alpha, pl->Additive, true);
 		}
 		*freehead = pl;
 		freehead = &pl->next;
+
+		context->Cycles.Unclock();
+		R_PopPortalContext();
 	}
 	firstvissprite = vissprites;
-	vissprite_p = vissprites + savedvissprite_p;
+	vissprite_p = vissprites + saved.FirstVissprite;
 	firstdrawseg = drawsegs;
-	ds_p = drawsegs + savedds_p;
+	ds_p = drawsegs + saved.FirstDrawseg;
 	InterestingDrawsegs.Resize ((unsigned int)FirstInterestingDrawseg);
-	FirstInterestingDrawseg = savedinteresting;
+	FirstInterestingDrawseg = saved.FirstInteresting;
 
-	lastopening = savedlastopening;
+	lastopening = saved.LastOpening;
 
-	camera = savedcamera;
-	viewsector = savedsector;
-	ViewPos = savedpos;
-	R_SetVisibility(savedvisibility);
-	extralight = savedextralight;
-	ViewAngle = savedangle;
-	R_SetViewAngle ();
+	saved.RestoreView();
 
 	CurrentPortalInSkybox = false;
 	R_3D_LeaveSkybox();
@@ -54,6 +54,11 @@
 #include "r_draw.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
+#include "c_dispatch.h"
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
 #define WALLYREPEAT 8
 
@@ -2634,7 +2639,7 @@ void R_StoreWallRange (int start, int stop)
 
 	if (rw_markportal)
 	{
-		PortalDrawseg pds;
+		PortalDrawseg &pds = *R_NewPortalDrawseg();
 		pds.src = curline->linedef;
 		pds.dst = curline->linedef->special == Line_Mirror? curline->linedef : curline->linedef->getPortalDestination();
 		pds.x1 = ds_p->x1;
@@ -2658,13 +2663,120 @@ void R_StoreWallRange (int start, int stop)
 		}
 
 		pds.mirror = curline->linedef->special == Line_Mirror;
-		WallPortals.Push(pds);
 	}
 
 	ds_p++;
 }
 
-int WallMostAny(short *mostbuf, double z1, double z2, const FWallCoords *wallc)
+//==========================================================================
+//
+// Per-column wall setup
+//
+// The SSE versions must produce exactly the same results as the C ones,
+// so the wall edges and texture coordinates do not depend on which path
+// was taken. This is also why the texture steps are still accumulated
+// one column at a time: only the divisions and conversions run in
+// parallel. The benchwallsetup command replays the walls of a frame
+// through both versions and compares them.
+//
+//==========================================================================
+
+struct FWallMostCapture
+{
+	FWallCoords wallc;
+	double z1, z2;
+};
+
+struct FPrepWallCapture
+{
+	FWallTmapVals tmap;
+	double walxrepeat;
+	int x1, x2;
+	bool lwallonly;
+};
+
+static bool WallSetupCapture;
+static TArray<FWallMostCapture> CapturedWallMost;
+static TArray<FPrepWallCapture> CapturedPrepWall;
+
+typedef void (*WallMostLineFunc)(short *mostbuf, float y1, float y2, int sx1, int sx2, bool clip);
+
+static void WallMostLine_C(short *mostbuf, float y1, float y2, int sx1, int sx2, bool clip)
+{
+	float rcp_delta = 1.0f / (sx2 - sx1);
+	if (!clip)
+	{
+		for (int x = sx1; x < sx2; x++)
+		{
+			float t = (x - sx1) * rcp_delta;
+			float y = y1 * (1.0f - t) + y2 * t;
+			mostbuf[x] = (short)xs_RoundToInt(y);
+		}
+	}
+	else
+	{
+		for (int x = sx1; x < sx2; x++)
+		{
+			float t = (x - sx1) * rcp_delta;
+			float y = y1 * (1.0f - t) + y2 * t;
+			mostbuf[x] = (short)clamp(xs_RoundToInt(y), 0, viewheight);
+		}
+	}
+}
+
+#ifndef NO_SSE
+
+// Same as xs_RoundToInt for four values
+static inline __m128i RoundToInt_SSE(__m128 v)
+{
+	const __m128d delta = _mm_set1_pd(_xs_doublemagicdelta);
+	__m128i lo = _mm_cvtpd_epi32(_mm_add_pd(_mm_cvtps_pd(v), delta));
+	__m128i hi = _mm_cvtpd_epi32(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), delta));
+	return _mm_unpacklo_epi64(lo, hi);
+}
+
+static void WallMostLine_SSE(short *mostbuf, float y1, float y2, int sx1, int sx2, bool clip)
+{
+	float rcp_delta = 1.0f / (sx2 - sx1);
+	int ssecount = (sx2 - sx1) & ~3;
+
+	__m128 mstep = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 mrcp_delta = _mm_set1_ps(rcp_delta);
+	__m128 my1 = _mm_set1_ps(y1);
+	__m128 my2 = _mm_set1_ps(y2);
+	const __m128 mone = _mm_set1_ps(1.0f);
+	const __m128 mfour = _mm_set1_ps(4.0f);
+	const __m128i mzero = _mm_setzero_si128();
+	const __m128i mviewheight = _mm_set1_epi16((short)viewheight);
+
+	short *dest = mostbuf + sx1;
+	for (int i = 0; i < ssecount; i += 4)
+	{
+		__m128 t = _mm_mul_ps(mstep, mrcp_delta);
+		__m128 y = _mm_add_ps(_mm_mul_ps(my1, _mm_sub_ps(mone, t)), _mm_mul_ps(my2, t));
+		__m128i iy = _mm_packs_epi32(RoundToInt_SSE(y), mzero);
+		if (clip)
+		{
+			iy = _mm_min_epi16(_mm_max_epi16(iy, mzero), mviewheight);
+		}
+		_mm_storel_epi64((__m128i*)(dest + i), iy);
+		mstep = _mm_add_ps(mstep, mfour);
+	}
+
+	for (int x = sx1 + ssecount; x < sx2; x++)
+	{
+		float t = (x - sx1) * rcp_delta;
+		float y = y1 * (1.0f - t) + y2 * t;
+		mostbuf[x] = (short)(clip ? clamp(xs_RoundToInt(y), 0, viewheight) : xs_RoundToInt(y));
+	}
+}
+
+#define WallMostLine WallMostLine_SSE
+#else
+#define WallMostLine WallMostLine_C
+#endif
+
+static int WallMostAny(short *mostbuf, double z1, double z2, const FWallCoords *wallc, WallMostLineFunc drawline)
 {
 	float y1 = (float)(CenterY - z1 * InvZtoScale / wallc->sz1);
 	float y2 = (float)(CenterY - z2 * InvZtoScale / wallc->sz2);
@@ -2683,27 +2795,19 @@ int WallMostAny(short *mostbuf, double z1, double z2, const FWallCoords *wallc)
 	if (wallc->sx2 <= wallc->sx1)
 		return 0;
 
-	float rcp_delta = 1.0f / (wallc->sx2 - wallc->sx1);
-	if (y1 >= 0.0f && y2 >= 0.0f && xs_RoundToInt(y1) <= viewheight && xs_RoundToInt(y2) <= viewheight)
-	{
-		for (int x = wallc->sx1; x < wallc->sx2; x++)
-		{
-			float t = (x - wallc->sx1) * rcp_delta;
-			float y = y1 * (1.0f - t) + y2 * t;
-			mostbuf[x] = (short)xs_RoundToInt(y);
-		}
-	}
-	else
+	bool clip = !(y1 >= 0.0f && y2 >= 0.0f && xs_RoundToInt(y1) <= viewheight && xs_RoundToInt(y2) <= viewheight);
+	drawline(mostbuf, y1, y2, wallc->sx1, wallc->sx2, clip);
+	return 0;
+}
+
+int WallMostAny(short *mostbuf, double z1, double z2, const FWallCoords *wallc)
+{
+	if (WallSetupCapture)
 	{
-		for (int x = wallc->sx1; x < wallc->sx2; x++)
-		{
-			float t = (x - wallc->sx1) * rcp_delta;
-			float y = y1 * (1.0f - t) + y2 * t;
-			mostbuf[x] = (short)clamp(xs_RoundToInt(y), 0, viewheight);
-		}
+		FWallMostCapture capture = { *wallc, z1, z2 };
+		CapturedWallMost.Push(capture);
 	}
-
-	return 0;
+	return WallMostAny(mostbuf, z1, z2, wallc, WallMostLine);
 }
 
 int OWallMost(short *mostbuf, double z, const FWallCoords *wallc)
@@ -2784,15 +2888,15 @@ int WallMost(short *mostbuf, const secplane_t &plane, const FWallCoords *wallc)
 	}
 }
 
-void PrepWall(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2)
+static void PrepWall_C(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap)
 {
-	float uOverZ = WallT.UoverZorg + WallT.UoverZstep * (float)(x1 + 0.5 - CenterX);
-	float invZ = WallT.InvZorg + WallT.InvZstep * (float)(x1 + 0.5 - CenterX);
-	float uGradient = WallT.UoverZstep;
-	float zGradient = WallT.InvZstep;
+	float uOverZ = tmap.UoverZorg + tmap.UoverZstep * (float)(x1 + 0.5 - CenterX);
+	float invZ = tmap.InvZorg + tmap.InvZstep * (float)(x1 + 0.5 - CenterX);
+	float uGradient = tmap.UoverZstep;
+	float zGradient = tmap.InvZstep;
 	float xrepeat = (float)walxrepeat;
-	float depthScale = (float)(WallT.InvZstep * WallTMapScale2);
-	float depthOrg = (float)(-WallT.UoverZstep * WallTMapScale2);
+	float depthScale = (float)(tmap.InvZstep * WallTMapScale2);
+	float depthOrg = (float)(-tmap.UoverZstep * WallTMapScale2);
 
 	if (xrepeat < 0.0f)
 	{
@@ -2822,12 +2926,12 @@ void PrepWall(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2)
 	}
 }
 
-void PrepLWall(fixed_t *upos, double walxrepeat, int x1, int x2)
+static void PrepLWall_C(fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap)
 {
-	float uOverZ = WallT.UoverZorg + WallT.UoverZstep * (float)(x1 + 0.5 - CenterX);
-	float invZ = WallT.InvZorg + WallT.InvZstep * (float)(x1 + 0.5 - CenterX);
-	float uGradient = WallT.UoverZstep;
-	float zGradient = WallT.InvZstep;
+	float uOverZ = tmap.UoverZorg + tmap.UoverZstep * (float)(x1 + 0.5 - CenterX);
+	float invZ = tmap.InvZorg + tmap.InvZstep * (float)(x1 + 0.5 - CenterX);
+	float uGradient = tmap.UoverZstep;
+	float zGradient = tmap.InvZstep;
 	float xrepeat = (float)walxrepeat;
 
 	if (xrepeat < 0.0f)
@@ -2856,6 +2960,260 @@ void PrepLWall(fixed_t *upos, double walxrepeat, int x1, int x2)
 	}
 }
 
+#ifndef NO_SSE
+
+// Gets the u/z and 1/z values of the next four columns, in the same order of additions as the C version.
+#define NEXT_UZ4(uz, iz) \
+	__m128 uz, iz; \
+	{ \
+		float u0 = uOverZ, i0 = invZ; uOverZ += uGradient; invZ += zGradient; \
+		float u1 = uOverZ, i1 = invZ; uOverZ += uGradient; invZ += zGradient; \
+		float u2 = uOverZ, i2 = invZ; uOverZ += uGradient; invZ += zGradient; \
+		float u3 = uOverZ, i3 = invZ; uOverZ += uGradient; invZ += zGradient; \
+		uz = _mm_setr_ps(u0, u1, u2, u3); \
+		iz = _mm_setr_ps(i0, i1, i2, i3); \
+	}
+
+static void PrepWall_SSE(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap)
+{
+	float uOverZ = tmap.UoverZorg + tmap.UoverZstep * (float)(x1 + 0.5 - CenterX);
+	float invZ = tmap.InvZorg + tmap.InvZstep * (float)(x1 + 0.5 - CenterX);
+	float uGradient = tmap.UoverZstep;
+	float zGradient = tmap.InvZstep;
+	float xrepeat = (float)walxrepeat;
+	float depthScale = (float)(tmap.InvZstep * WallTMapScale2);
+	float depthOrg = (float)(-tmap.UoverZstep * WallTMapScale2);
+
+	__m128 mxrepeat = _mm_set1_ps(xrepeat);
+	__m128 mdepthScale = _mm_set1_ps(depthScale);
+	__m128 mdepthOrg = _mm_set1_ps(depthOrg);
+	const __m128 mfracunit = _mm_set1_ps((float)FRACUNIT);
+
+	int x = x1;
+	if (xrepeat < 0.0f)
+	{
+		for (; x + 4 <= x2; x += 4)
+		{
+			NEXT_UZ4(uz, iz);
+			__m128 u = _mm_div_ps(uz, iz);
+			_mm_storeu_si128((__m128i*)(upos + x), _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(mxrepeat, _mm_mul_ps(u, mxrepeat)), mfracunit)));
+			_mm_storeu_ps(vstep + x, _mm_add_ps(mdepthOrg, _mm_mul_ps(u, mdepthScale)));
+		}
+		for (; x < x2; x++)
+		{
+			float u = uOverZ / invZ;
+			upos[x] = (fixed_t)((xrepeat - u * xrepeat) * FRACUNIT);
+			vstep[x] = depthOrg + u * depthScale;
+			uOverZ += uGradient;
+			invZ += zGradient;
+		}
+	}
+	else
+	{
+		for (; x + 4 <= x2; x += 4)
+		{
+			NEXT_UZ4(uz, iz);
+			__m128 u = _mm_div_ps(uz, iz);
+			_mm_storeu_si128((__m128i*)(upos + x), _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(u, mxrepeat), mfracunit)));
+			_mm_storeu_ps(vstep + x, _mm_add_ps(mdepthOrg, _mm_mul_ps(u, mdepthScale)));
+		}
+		for (; x < x2; x++)
+		{
+			float u = uOverZ / invZ;
+			upos[x] = (fixed_t)(u * xrepeat * FRACUNIT);
+			vstep[x] = depthOrg + u * depthScale;
+			uOverZ += uGradient;
+			invZ += zGradient;
+		}
+	}
+}
+
+static void PrepLWall_SSE(fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap)
+{
+	float uOverZ = tmap.UoverZorg + tmap.UoverZstep * (float)(x1 + 0.5 - CenterX);
+	float invZ = tmap.InvZorg + tmap.InvZstep * (float)(x1 + 0.5 - CenterX);
+	float uGradient = tmap.UoverZstep;
+	float zGradient = tmap.InvZstep;
+	float xrepeat = (float)walxrepeat;
+
+	__m128 mxrepeat = _mm_set1_ps(xrepeat);
+	const __m128 mfracunit = _mm_set1_ps((float)FRACUNIT);
+
+	int x = x1;
+	if (xrepeat < 0.0f)
+	{
+		for (; x + 4 <= x2; x += 4)
+		{
+			NEXT_UZ4(uz, iz);
+			__m128 u = _mm_sub_ps(_mm_mul_ps(_mm_div_ps(uz, iz), mxrepeat), mxrepeat);
+			_mm_storeu_si128((__m128i*)(upos + x), _mm_cvttps_epi32(_mm_mul_ps(u, mfracunit)));
+		}
+		for (; x < x2; x++)
+		{
+			float u = uOverZ / invZ * xrepeat - xrepeat;
+			upos[x] = (fixed_t)(u * FRACUNIT);
+			uOverZ += uGradient;
+			invZ += zGradient;
+		}
+	}
+	else
+	{
+		for (; x + 4 <= x2; x += 4)
+		{
+			NEXT_UZ4(uz, iz);
+			__m128 u = _mm_mul_ps(_mm_div_ps(uz, iz), mxrepeat);
+			_mm_storeu_si128((__m128i*)(upos + x), _mm_cvttps_epi32(_mm_mul_ps(u, mfracunit)));
+		}
+		for (; x < x2; x++)
+		{
+			float u = uOverZ / invZ * xrepeat;
+			upos[x] = (fixed_t)(u * FRACUNIT);
+			uOverZ += uGradient;
+			invZ += zGradient;
+		}
+	}
+}
+
+#undef NEXT_UZ4
+#endif
+
+void PrepWall(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2)
+{
+	if (WallSetupCapture)
+	{
+		FPrepWallCapture capture = { WallT, walxrepeat, x1, x2, false };
+		CapturedPrepWall.Push(capture);
+	}
+#ifndef NO_SSE
+	PrepWall_SSE(vstep, upos, walxrepeat, x1, x2, WallT);
+#else
+	PrepWall_C(vstep, upos, walxrepeat, x1, x2, WallT);
+#endif
+}
+
+void PrepLWall(fixed_t *upos, double walxrepeat, int x1, int x2)
+{
+	if (WallSetupCapture)
+	{
+		FPrepWallCapture capture = { WallT, walxrepeat, x1, x2, true };
+		CapturedPrepWall.Push(capture);
+	}
+#ifndef NO_SSE
+	PrepLWall_SSE(upos, walxrepeat, x1, x2, WallT);
+#else
+	PrepLWall_C(upos, walxrepeat, x1, x2, WallT);
+#endif
+}
+
+//==========================================================================
+//
+// CCMD benchwallsetup
+//
+// Captures the per-column wall setup inputs of the next rendered frame,
+// then replays them through the C and the SSE versions, compares the
+// results and prints the time each one took.
+//
+//==========================================================================
+
+CCMD(benchwallsetup)
+{
+	CapturedWallMost.Clear();
+	CapturedPrepWall.Clear();
+	WallSetupCapture = true;
+}
+
+typedef void (*PrepWallFunc)(float *vstep, fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap);
+typedef void (*PrepLWallFunc)(fixed_t *upos, double walxrepeat, int x1, int x2, const FWallTmapVals &tmap);
+
+static double TimeWallSetup(WallMostLineFunc drawline, PrepWallFunc prepwall, PrepLWallFunc preplwall, int repeats)
+{
+	static short most[MAXWIDTH];
+	static float vstep[MAXWIDTH];
+	static fixed_t upos[MAXWIDTH];
+	cycle_t clock;
+
+	clock.Reset();
+	clock.Clock();
+	for (int r = 0; r < repeats; r++)
+	{
+		for (unsigned i = 0; i < CapturedWallMost.Size(); i++)
+		{
+			FWallMostCapture &c = CapturedWallMost[i];
+			WallMostAny(most, c.z1, c.z2, &c.wallc, drawline);
+		}
+		for (unsigned i = 0; i < CapturedPrepWall.Size(); i++)
+		{
+			FPrepWallCapture &c = CapturedPrepWall[i];
+			if (c.lwallonly) preplwall(upos, c.walxrepeat, c.x1, c.x2, c.tmap);
+			else prepwall(vstep, upos, c.walxrepeat, c.x1, c.x2, c.tmap);
+		}
+	}
+	clock.Unclock();
+	return clock.TimeMS();
+}
+
+#ifndef NO_SSE
+static int CompareWallSetup()
+{
+	static short most1[MAXWIDTH], most2[MAXWIDTH];
+	static float vstep1[MAXWIDTH], vstep2[MAXWIDTH];
+	static fixed_t upos1[MAXWIDTH], upos2[MAXWIDTH];
+	int mismatches = 0;
+
+	// Compare the bit patterns so that NaNs and negative zeroes count too.
+	for (unsigned i = 0; i < CapturedWallMost.Size(); i++)
+	{
+		FWallMostCapture &c = CapturedWallMost[i];
+		memset(most1, 0, sizeof(most1));
+		memset(most2, 0, sizeof(most2));
+		WallMostAny(most1, c.z1, c.z2, &c.wallc, WallMostLine_C);
+		WallMostAny(most2, c.z1, c.z2, &c.wallc, WallMostLine_SSE);
+		if (memcmp(most1, most2, sizeof(most1)) != 0) mismatches++;
+	}
+	for (unsigned i = 0; i < CapturedPrepWall.Size(); i++)
+	{
+		FPrepWallCapture &c = CapturedPrepWall[i];
+		memset(vstep1, 0, sizeof(vstep1));
+		memset(vstep2, 0, sizeof(vstep2));
+		memset(upos1, 0, sizeof(upos1));
+		memset(upos2, 0, sizeof(upos2));
+		if (c.lwallonly)
+		{
+			PrepLWall_C(upos1, c.walxrepeat, c.x1, c.x2, c.tmap);
+			PrepLWall_SSE(upos2, c.walxrepeat, c.x1, c.x2, c.tmap);
+		}
+		else
+		{
+			PrepWall_C(vstep1, upos1, c.walxrepeat, c.x1, c.x2, c.tmap);
+			PrepWall_SSE(vstep2, upos2, c.walxrepeat, c.x1, c.x2, c.tmap);
+		}
+		if (memcmp(vstep1, vstep2, sizeof(vstep1)) != 0 || memcmp(upos1, upos2, sizeof(upos1)) != 0) mismatches++;
+	}
+	return mismatches;
+}
+#endif
+
+void R_FinishWallSetupCapture()
+{
+	if (!WallSetupCapture) return;
+	WallSetupCapture = false;
+
+	const int repeats = 100;
+	double ctime = TimeWallSetup(WallMostLine_C, PrepWall_C, PrepLWall_C, repeats);
+#ifndef NO_SSE
+	double ssetime = TimeWallSetup(WallMostLine_SSE, PrepWall_SSE, PrepLWall_SSE, repeats);
+	int mismatches = CompareWallSetup();
+
+	Printf("%u wall edges, %u texture setups, %d runs: C %.3f ms, SSE %.3f ms, %d mismatches\n",
+		CapturedWallMost.Size(), CapturedPrepWall.Size(), repeats, ctime, ssetime, mismatches);
+#else
+	Printf("%u wall edges, %u texture setups, %d runs: C %.3f ms\n",
+		CapturedWallMost.Size(), CapturedPrepWall.Size(), repeats, ctime);
+#endif
+	CapturedWallMost.Clear();
+	CapturedPrepWall.Clear();
+}
+
 // pass = 0: when seg is first drawn
 //		= 1: drawing masked textures (including sprites)
 // Currently, only pass = 0 is done or used
@@ -35,6 +35,7 @@ int OWallMost (short *mostbuf, double z, const FWallCoords *wallc);
 int WallMost (short *mostbuf, const secplane_t &plane, const FWallCoords *wallc);
 void PrepWall (float *swall, fixed_t *lwall, double walxrepeat, int x1, int x2);
 void PrepLWall (fixed_t *lwall, double walxrepeat, int x1, int x2);
+void R_FinishWallSetupCapture();
 
 ptrdiff_t R_NewOpening (ptrdiff_t len);
 
@@ -68,6 +69,8 @@ struct PortalDrawseg
 extern PortalDrawseg* CurrentPortal;
 extern int CurrentPortalUniq;
 extern bool CurrentPortalInSkybox;
-extern TArray<PortalDrawseg> WallPortals;
+extern TArray<PortalDrawseg *> WallPortals;
+
+PortalDrawseg *R_NewPortalDrawseg ();
 
 #endif
@@ -170,6 +170,8 @@ void FSoftwareRenderer::RenderView(player_t *player)
 		R_InitColumnDrawers();
 	}
 
+	R_UpdateColormaps();
+
 	R_BeginDrawerCommands();
 	R_RenderActorView (player->mo);
 	R_DetailDouble ();		// [RH] Apply detail mode expansion
@@ -213,6 +215,7 @@ void FSoftwareRenderer::WriteSavePic (player_t *player, FileWriter *file, int wi
 	// Take a snapshot of the player's view
 	pic->ObjectFlags |= OF_Fixed;
 	pic->Lock ();
+	R_UpdateColormaps ();
 	R_RenderViewToCanvas (player->mo, pic, 0, 0, width, height);
 	screen->GetFlashedPalette (palette);
 	M_CreatePNG (file, pic->GetBuffer(), palette, SS_PAL, width, height, pic->GetPitch());
@@ -65,6 +65,7 @@
 #include "r_data/voxels.h"
 #include "p_local.h"
 #include "p_maputl.h"
+#include "profiler.h"
 
 // [RH] A c-buffer. Used for keeping track of offscreen voxel spans.
 
@@ -2475,6 +2476,8 @@ void R_DrawHeightPlanes(double height); // kg3D - fake planes
 
 void R_DrawMasked (void)
 {
+	FProfileScope profile("Masked");
+
 	R_CollectPortals();
 	R_SortVisSprites (DrewAVoxel ? sv_compare2d : sv_compare, firstvissprite - vissprites);
 
@@ -324,6 +324,107 @@ CUSTOM_CVAR (Int, screenblocks, 10, CVAR_ARCHIVE)
 		R_SetViewSize (self);
 }
 
+//==========================================================================
+//
+// Flattened BSP
+//
+// The node descents only need the partition lines and the child links,
+// so they are copied into a compact array where several nodes share a
+// cache line that would only hold one node_t. The bounding boxes, which
+// only the renderer checks and only for the back side, are kept in a
+// separate array with the same indices. Nodes are stored depth-first
+// from the root, so a node is usually directly followed by its front
+// child.
+//
+//==========================================================================
+
+static TArray<FPointNode> PointNodes;
+static TArray<FPointNodeBox> PointNodeBoxes;
+static node_t *PointNodesSource;
+static int PointNodesCount;
+
+static DWORD R_FlattenPointNode(void *child, unsigned &next)
+{
+	if ((size_t)child & 1)
+	{
+		return DWORD((subsector_t *)((BYTE *)child - 1) - subsectors) | POINTNODE_SUBSECTOR;
+	}
+
+	node_t *node = (node_t *)child;
+	unsigned index = next++;
+	FPointNode &pn = PointNodes[index];		// the array never reallocates here
+	pn.x = node->x;
+	pn.y = node->y;
+	pn.dx = node->dx;
+	pn.dy = node->dy;
+	memcpy(PointNodeBoxes[index].bbox, node->bbox, sizeof(node->bbox));
+	pn.children[0] = R_FlattenPointNode(node->children[0], next);
+	pn.children[1] = R_FlattenPointNode(node->children[1], next);
+	return index;
+}
+
+//==========================================================================
+//
+// R_ClearPointNodes
+//
+// Called when the level is freed, so that a new level whose nodes end up
+// at the same address is not mistaken for the old one.
+//
+//==========================================================================
+
+void R_ClearPointNodes ()
+{
+	PointNodes.Clear();
+	PointNodeBoxes.Clear();
+	PointNodesSource = NULL;
+	PointNodesCount = 0;
+}
+
+//==========================================================================
+//
+// R_BuildPointNodes
+//
+// Must be called whenever the level's nodes change.
+//
+//==========================================================================
+
+void R_BuildPointNodes ()
+{
+	R_ClearPointNodes();
+	if (numnodes > 0)
+	{
+		unsigned next = 0;
+		PointNodes.Resize(numnodes);
+		PointNodeBoxes.Resize(numnodes);
+		R_FlattenPointNode(nodes + numnodes - 1, next);
+		PointNodes.Resize(next);
+		PointNodes.ShrinkToFit();
+		PointNodeBoxes.Resize(next);
+		PointNodeBoxes.ShrinkToFit();
+		PointNodesSource = nodes;
+		PointNodesCount = numnodes;
+	}
+}
+
+//==========================================================================
+//
+// R_GetPointNodes
+//
+// Returns the flattened BSP, or NULL if it does not match the level's
+// nodes, in which case the node_t tree has to be used.
+//
+//==========================================================================
+
+const FPointNode *R_GetPointNodes (const FPointNodeBox **boxes)
+{
+	if (PointNodesSource != nodes || PointNodesCount != numnodes || numnodes == 0)
+	{
+		return NULL;
+	}
+	if (boxes != NULL) *boxes = &PointNodeBoxes[0];
+	return &PointNodes[0];
+}
+
 //==========================================================================
 //
 // R_PointInSubsector
@@ -338,7 +439,22 @@ subsector_t *R_PointInSubsector (fixed_t x, fixed_t y)
 	// single subsector is a special case
 	if (numnodes == 0)
 		return subsectors;
-				
+
+	const FPointNode *pn = R_GetPointNodes();
+	if (pn != NULL)
+	{
+		DWORD child = 0;
+
+		do
+		{
+			const FPointNode &n = pn[child];
+			child = n.children[DMulScale32 (y-n.y, n.dx, n.x-x, n.dy) > 0];
+		}
+		while (!(child & POINTNODE_SUBSECTOR));
+
+		return &subsectors[child & ~POINTNODE_SUBSECTOR];
+	}
+
 	node = nodes + numnodes - 1;
 
 	do
@@ -351,6 +467,234 @@ subsector_t *R_PointInSubsector (fixed_t x, fixed_t y)
 	return (subsector_t *)((BYTE *)node - 1);
 }
 
+//==========================================================================
+//
+// R_PointInConvexSubsector
+//
+// Checks if a point is well inside a closed, convex subsector, in which
+// case the BSP would return the same subsector. Open subsectors (from
+// non-GL nodes) and points close to an edge always fail. If the point is
+// clearly outside exactly one edge, that seg is returned in *exit.
+//
+//==========================================================================
+
+static bool R_PointInConvexSubsector(const subsector_t *sub, double x, double y, const seg_t **exit)
+{
+	const seg_t *seg = sub->firstline;
+	const seg_t *last = seg + sub->numlines - 1;
+	const seg_t *outside = NULL;
+	bool inside = true;
+
+	if (exit != NULL) *exit = NULL;
+	if (sub->numlines < 3 || seg->v1 != last->v2)
+	{
+		return false;
+	}
+	for (; seg <= last; seg++)
+	{
+		if (seg < last && seg->v2 != seg[1].v1)
+		{
+			return false;
+		}
+		double x1 = seg->v1->fX(), y1 = seg->v1->fY();
+		double dx = seg->v2->fX() - x1, dy = seg->v2->fY() - y1;
+		double margin = (fabs(dx) + fabs(dy)) * (2 / 65536.);
+		double dist = (y - y1) * dx + (x1 - x) * dy;
+
+		// The BSP works on fixed point coordinates, so keep some distance
+		// to the edge to be certain it'd give the same result.
+		if (dist > -margin)
+		{
+			inside = false;
+			if (dist <= margin || outside != NULL)
+			{
+				return false;
+			}
+			outside = seg;
+		}
+	}
+	if (exit != NULL) *exit = outside;
+	return inside;
+}
+
+//==========================================================================
+//
+// R_PointInSubsector with a hint
+//
+// Most callers look up a point that is close to where it was the last
+// time. This checks the previous subsector and the one behind the edge
+// the point crossed before doing the full descent. The hint may be stale
+// or from another level.
+//
+//==========================================================================
+
+subsector_t *R_PointInSubsector (const DVector2 &pos, subsector_t *hint)
+{
+	if (hint != NULL && hint >= subsectors && hint < subsectors + numsubsectors &&
+		((BYTE *)hint - (BYTE *)subsectors) % sizeof(subsector_t) == 0)
+	{
+		const seg_t *exit;
+
+		if (R_PointInConvexSubsector(hint, pos.X, pos.Y, &exit))
+		{
+			return hint;
+		}
+		if (exit != NULL && exit->PartnerSeg != NULL)
+		{
+			subsector_t *next = exit->PartnerSeg->Subsector;
+			if (next != NULL && R_PointInConvexSubsector(next, pos.X, pos.Y, NULL))
+			{
+				return next;
+			}
+		}
+	}
+	return R_PointInSubsector(pos);
+}
+
+//==========================================================================
+//
+// CCMD pointinsubsectorbench
+//
+// Measures lookups per second for random points within the level, with
+// and without a hint from a nearby earlier lookup.
+//
+//==========================================================================
+
+CCMD (pointinsubsectorbench)
+{
+	if (numvertexes == 0 || numsubsectors == 0)
+	{
+		Printf ("No level loaded\n");
+		return;
+	}
+
+	double minx = vertexes[0].fX(), maxx = minx, miny = vertexes[0].fY(), maxy = miny;
+	for (int i = 1; i < numvertexes; i++)
+	{
+		minx = MIN(minx, vertexes[i].fX());
+		maxx = MAX(maxx, vertexes[i].fX());
+		miny = MIN(miny, vertexes[i].fY());
+		maxy = MAX(maxy, vertexes[i].fY());
+	}
+
+	const int count = 1000000;
+	TArray<DVector2> points(count, true);
+	DWORD seed = 0x12345678;
+	for (int i = 0; i < count; i += 16)
+	{
+		// Walk in short, random steps like a moving actor.
+		seed = seed * 1664525 + 1013904223;
+		DVector2 p(minx + (maxx - minx) * (seed >> 8) / 16777216., 0);
+		seed = seed * 1664525 + 1013904223;
+		p.Y = miny + (maxy - miny) * (seed >> 8) / 16777216.;
+		for (int j = i; j < i + 16 && j < count; j++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			p.X += int(seed >> 28) - 8;
+			p.Y += int((seed >> 24) & 15) - 8;
+			points[j] = p;
+		}
+	}
+
+	cycle_t full, hinted;
+	size_t check = 0;
+	full.Reset();
+	full.Clock();
+	for (int i = 0; i < count; i++)
+	{
+		check += size_t(R_PointInSubsector(points[i]));
+	}
+	full.Unclock();
+
+	subsector_t *hint = NULL;
+	hinted.Reset();
+	hinted.Clock();
+	for (int i = 0; i < count; i++)
+	{
+		hint = R_PointInSubsector(points[i], hint);
+		check -= size_t(hint);
+	}
+	hinted.Unclock();
+
+	Printf ("%d lookups: full %.0f/s, hinted %.0f/s%s\n", count,
+		count * 1000. / MAX(full.TimeMS(), 0.001), count * 1000. / MAX(hinted.TimeMS(), 0.001),
+		check != 0 ? " (results differ!)" : "");
+}
+
+//==========================================================================
+//
+// CCMD bspwalkbench
+//
+// Compares full front-to-back walks of the level's BSP through the node_t
+// tree and through the flattened copy the renderer uses. Nothing gets
+// clipped, so every node is visited and its back side's bounding box is
+// read, like the renderer does for every node it does not reject.
+//
+//==========================================================================
+
+static DWORD WalkNodeTree (void *node, fixed_t x, fixed_t y, DWORD check)
+{
+	while (!((size_t)node & 1))
+	{
+		node_t *bsp = (node_t *)node;
+		int side = R_PointOnSide (x, y, bsp);
+		check = WalkNodeTree (bsp->children[side], x, y, check);
+		side ^= 1;
+		check += FLOAT2FIXED(bsp->bbox[side][BOXTOP]) > y;
+		node = bsp->children[side];
+	}
+	return check * 31 + DWORD((subsector_t *)((BYTE *)node - 1) - subsectors);
+}
+
+static DWORD WalkPointNodes (const FPointNode *pn, const FPointNodeBox *boxes, DWORD index, fixed_t x, fixed_t y, DWORD check)
+{
+	while (!(index & POINTNODE_SUBSECTOR))
+	{
+		const FPointNode &bsp = pn[index];
+		int side = DMulScale32 (y - bsp.y, bsp.dx, bsp.x - x, bsp.dy) > 0;
+		check = WalkPointNodes (pn, boxes, bsp.children[side], x, y, check);
+		side ^= 1;
+		check += FLOAT2FIXED(boxes[index].bbox[side][BOXTOP]) > y;
+		index = bsp.children[side];
+	}
+	return check * 31 + (index & ~POINTNODE_SUBSECTOR);
+}
+
+CCMD (bspwalkbench)
+{
+	const FPointNodeBox *boxes;
+	const FPointNode *pn = R_GetPointNodes (&boxes);
+	if (pn == NULL)
+	{
+		Printf ("No level loaded\n");
+		return;
+	}
+
+	const int count = 200;
+	cycle_t tree, flat;
+	DWORD check1 = 0, check2 = 0;
+	tree.Reset();
+	flat.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		// View from the center of a random subsector.
+		subsector_t *sub = &subsectors[(DWORD(i) * 2654435761u) % numsubsectors];
+		fixed_t x = FLOAT2FIXED((sub->firstline->v1->fX() + sub->firstline->v2->fX()) / 2);
+		fixed_t y = FLOAT2FIXED((sub->firstline->v1->fY() + sub->firstline->v2->fY()) / 2);
+
+		tree.Clock();
+		check1 = WalkNodeTree (nodes + numnodes - 1, x, y, check1);
+		tree.Unclock();
+
+		flat.Clock();
+		check2 = WalkPointNodes (pn, boxes, 0, x, y, check2);
+		flat.Unclock();
+	}
+
+	Printf ("%d walks of %d nodes: node_t %.3f ms, flattened %.3f ms%s\n", count, numnodes,
+		tree.TimeMS() / count, flat.TimeMS() / count, check1 != check2 ? " (results differ!)" : "");
+}
+
 //==========================================================================
 //
 // R_Init
@@ -85,6 +85,25 @@ inline subsector_t *R_PointInSubsector(const DVector2 &pos)
 {
 	return R_PointInSubsector(FLOAT2FIXED(pos.X), FLOAT2FIXED(pos.Y));
 }
+subsector_t *R_PointInSubsector (const DVector2 &pos, subsector_t *hint);
+
+// Flattened copy of the level's BSP, built by R_BuildPointNodes.
+struct FPointNode
+{
+	fixed_t x, y, dx, dy;
+	DWORD children[2];		// index of the child node or, with the high bit set, the subsector
+};
+
+struct FPointNodeBox
+{
+	float bbox[2][4];		// Bounding box for each child.
+};
+
+enum { POINTNODE_SUBSECTOR = 0x80000000 };
+
+void R_BuildPointNodes ();
+void R_ClearPointNodes ();
+const FPointNode *R_GetPointNodes (const FPointNodeBox **boxes = NULL);
 void R_ResetViewInterpolation ();
 void R_RebuildViewInterpolation(player_t *player);
 bool R_GetViewInterpolationStatus();
@@ -53,6 +53,7 @@
 #include "serializer.h"
 #include "d_player.h"
 #include "r_state.h"
+#include "profiler.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -111,6 +112,8 @@ static void CalcPolyobjSoundOrg(const DVector3 &listenpos, const FPolyObj *poly,
 static FSoundChan *S_StartSound(AActor *mover, const sector_t *sec, const FPolyObj *poly,
 	const FVector3 *pt, int channel, FSoundID sound_id, float volume, float attenuation, FRolloffInfo *rolloff);
 static void S_SetListener(SoundListener &listener, AActor *listenactor);
+static void S_IndexChannel(FSoundChan *chan);
+static void S_UnindexChannel(FSoundChan *chan);
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
@@ -121,6 +124,13 @@ static FString	 LastSong;			// last music that was played
 static FPlayList *PlayList;
 static int		RestartEvictionsAt;	// do not restart evicted channels before this level.time
 
+// Playing channels are additionally hashed by their source object and by
+// their sound so that per-actor and per-sound queries do not have to walk
+// every playing channel.
+enum { CHAN_HASH_SIZE = 256 };
+static FSoundChan *SourceChannels[CHAN_HASH_SIZE];
+static FSoundChan *SfxChannels[CHAN_HASH_SIZE];
+
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 int sfx_empty;
@@ -595,6 +605,7 @@ FISoundChannel *S_GetChannel(void *syschan)
 
 void S_ReturnChannel(FSoundChan *chan)
 {
+	S_UnindexChannel(chan);
 	S_UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	S_LinkChannel(chan, &FreeChannels);
@@ -632,6 +643,103 @@ void S_LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// SourceHash
+//
+// Actor, sector and polyobject sources all share the same hash. Channels
+// of other source types are not in it.
+//
+//==========================================================================
+
+static inline FSoundChan **SourceHash(const void *source)
+{
+	return &SourceChannels[(size_t(source) >> 4) % CHAN_HASH_SIZE];
+}
+
+static inline bool HasSourceObject(const FSoundChan *chan)
+{
+	return chan->SourceType == SOURCE_Actor || chan->SourceType == SOURCE_Sector || chan->SourceType == SOURCE_Polyobj;
+}
+
+static inline const void *SourceObject(const FSoundChan *chan)
+{
+	switch (chan->SourceType)
+	{
+	case SOURCE_Actor:		return chan->Actor;
+	case SOURCE_Sector:		return chan->Sector;
+	case SOURCE_Polyobj:	return chan->Poly;
+	default:				return NULL;
+	}
+}
+
+//==========================================================================
+//
+// S_IndexChannel
+//
+// Adds a channel to the source and sound hashes. Must be called again
+// (after S_UnindexChannel) whenever a channel's source changes.
+//
+//==========================================================================
+
+static void S_IndexChannel(FSoundChan *chan)
+{
+	FSoundChan **head;
+
+	if (HasSourceObject(chan) && chan->PrevSourceChan == NULL)
+	{
+		head = SourceHash(SourceObject(chan));
+		chan->NextSourceChan = *head;
+		if (chan->NextSourceChan != NULL)
+		{
+			chan->NextSourceChan->PrevSourceChan = &chan->NextSourceChan;
+		}
+		*head = chan;
+		chan->PrevSourceChan = head;
+	}
+	if (chan->PrevSfxChan == NULL)
+	{
+		head = &SfxChannels[chan->SoundID % CHAN_HASH_SIZE];
+		chan->NextSfxChan = *head;
+		if (chan->NextSfxChan != NULL)
+		{
+			chan->NextSfxChan->PrevSfxChan = &chan->NextSfxChan;
+		}
+		*head = chan;
+		chan->PrevSfxChan = head;
+	}
+}
+
+//==========================================================================
+//
+// S_UnindexChannel
+//
+//==========================================================================
+
+static void S_UnindexChannel(FSoundChan *chan)
+{
+	if (chan->PrevSourceChan != NULL)
+	{
+		*(chan->PrevSourceChan) = chan->NextSourceChan;
+		if (chan->NextSourceChan != NULL)
+		{
+			chan->NextSourceChan->PrevSourceChan = chan->PrevSourceChan;
+		}
+		chan->NextSourceChan = NULL;
+		chan->PrevSourceChan = NULL;
+	}
+	if (chan->PrevSfxChan != NULL)
+	{
+		*(chan->PrevSfxChan) = chan->NextSfxChan;
+		if (chan->NextSfxChan != NULL)
+		{
+			chan->NextSfxChan->PrevSfxChan = chan->PrevSfxChan;
+		}
+		chan->NextSfxChan = NULL;
+		chan->PrevSfxChan = NULL;
+	}
+}
+
 // [RH] Split S_StartSoundAtVolume into multiple parts so that sounds can
 //		be specified both by id and by name. Also borrowed some stuff from
 //		Hexen and parameters from Quake.
@@ -1052,7 +1160,11 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 	// If this actor is already playing something on the selected channel, stop it.
 	if (type != SOURCE_None && ((actor == NULL && channel != CHAN_AUTO) || (actor != NULL && S_IsChannelUsed(actor, channel, &seen))))
 	{
-		for (chan = Channels; chan != NULL; chan = chan->NextChan)
+		const void *source = type == SOURCE_Actor ? (const void *)actor : type == SOURCE_Sector ? (const void *)sec : (const void *)poly;
+		FSoundChan *first = type == SOURCE_Unattached ? Channels : *SourceHash(source);
+		bool bysource = type != SOURCE_Unattached;
+
+		for (chan = first; chan != NULL; chan = bysource ? chan->NextSourceChan : chan->NextChan)
 		{
 			if (chan->SourceType == type && chan->EntChannel == channel)
 			{
@@ -1151,6 +1263,7 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 		case SOURCE_Unattached:	chan->Point[0] = pt->X; chan->Point[1] = pt->Y; chan->Point[2] = pt->Z;	break;
 		default:										break;
 		}
+		S_IndexChannel(chan);
 	}
 	return chan;
 }
@@ -1507,7 +1620,7 @@ bool S_CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_limit, floa
 	FSoundChan *chan;
 	int count;
 	
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	for (chan = SfxChannels[unsigned(sfx - &S_sfx[0]) % CHAN_HASH_SIZE], count = 0; chan != NULL && count < near_limit; chan = chan->NextSfxChan)
 	{
 		if (!(chan->ChanFlags & CHAN_EVICTED) && &S_sfx[chan->SoundID] == sfx)
 		{
@@ -1562,10 +1675,10 @@ void S_StopSound (int channel)
 
 void S_StopSound (AActor *actor, int channel)
 {
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = *SourceHash(actor);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
+		FSoundChan *next = chan->NextSourceChan;
 		if (chan->SourceType == SOURCE_Actor &&
 			chan->Actor == actor &&
 			(chan->EntChannel == channel || (i_compatflags & COMPATF_MAGICSILENCE)))
@@ -1586,10 +1699,10 @@ void S_StopSound (AActor *actor, int channel)
 
 void S_StopSound (const sector_t *sec, int channel)
 {
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = *SourceHash(sec);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
+		FSoundChan *next = chan->NextSourceChan;
 		if (chan->SourceType == SOURCE_Sector &&
 			chan->Sector == sec &&
 			(chan->EntChannel == channel || (i_compatflags & COMPATF_MAGICSILENCE)))
@@ -1610,10 +1723,10 @@ void S_StopSound (const sector_t *sec, int channel)
 
 void S_StopSound (const FPolyObj *poly, int channel)
 {
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = *SourceHash(poly);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
+		FSoundChan *next = chan->NextSourceChan;
 		if (chan->SourceType == SOURCE_Polyobj &&
 			chan->Poly == poly &&
 			(chan->EntChannel == channel || (i_compatflags & COMPATF_MAGICSILENCE)))
@@ -1657,24 +1770,28 @@ void S_RelinkSound (AActor *from, AActor *to)
 	if (from == NULL)
 		return;
 
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = *SourceHash(from);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
+		FSoundChan *next = chan->NextSourceChan;
 		if (chan->SourceType == SOURCE_Actor && chan->Actor == from)
 		{
 			if (to != NULL)
 			{
+				S_UnindexChannel(chan);
 				chan->Actor = to;
+				S_IndexChannel(chan);
 			}
 			else if (!(chan->ChanFlags & CHAN_LOOP) && !(compatflags2 & COMPATF2_SOUNDCUTOFF))
 			{
+				S_UnindexChannel(chan);
 				chan->Actor = NULL;
 				chan->SourceType = SOURCE_Unattached;
 				FVector3 p = from->SoundPos();
 				chan->Point[0] = p.X;
 				chan->Point[1] = p.Y;
 				chan->Point[2] = p.Z;
+				S_IndexChannel(chan);
 			}
 			else
 			{
@@ -1700,7 +1817,7 @@ bool S_ChangeSoundVolume(AActor *actor, int channel, float volume)
 	else if (volume > 1.0)
 		volume = 1.0;
 
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = *SourceHash(actor); chan != NULL; chan = chan->NextSourceChan)
 	{
 		if (chan->SourceType == SOURCE_Actor &&
 			chan->Actor == actor &&
@@ -1725,7 +1842,7 @@ bool S_GetSoundPlayingInfo (const AActor *actor, int sound_id)
 {
 	if (sound_id > 0)
 	{
-		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan *chan = *SourceHash(actor); chan != NULL; chan = chan->NextSourceChan)
 		{
 			if (chan->OrgID == sound_id &&
 				chan->SourceType == SOURCE_Actor &&
@@ -1742,7 +1859,7 @@ bool S_GetSoundPlayingInfo (const sector_t *sec, int sound_id)
 {
 	if (sound_id > 0)
 	{
-		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan *chan = *SourceHash(sec); chan != NULL; chan = chan->NextSourceChan)
 		{
 			if (chan->OrgID == sound_id &&
 				chan->SourceType == SOURCE_Sector &&
@@ -1759,7 +1876,7 @@ bool S_GetSoundPlayingInfo (const FPolyObj *poly, int sound_id)
 {
 	if (sound_id > 0)
 	{
-		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan *chan = *SourceHash(poly); chan != NULL; chan = chan->NextSourceChan)
 		{
 			if (chan->OrgID == sound_id &&
 				chan->SourceType == SOURCE_Polyobj &&
@@ -1788,7 +1905,7 @@ static bool S_IsChannelUsed(AActor *actor, int channel, int *seen)
 	{
 		return true;
 	}
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = *SourceHash(actor); chan != NULL; chan = chan->NextSourceChan)
 	{
 		if (chan->SourceType == SOURCE_Actor && chan->Actor == actor)
 		{
@@ -1815,7 +1932,7 @@ bool S_IsActorPlayingSomething (AActor *actor, int channel, int sound_id)
 		channel = 0;
 	}
 
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = *SourceHash(actor); chan != NULL; chan = chan->NextSourceChan)
 	{
 		if (chan->SourceType == SOURCE_Actor && chan->Actor == actor)
 		{
@@ -2008,6 +2125,7 @@ void S_RestoreEvictedChannels()
 
 void S_UpdateSounds (AActor *listenactor)
 {
+	FProfileScope profile("Sound");
 	FVector3 pos, vel;
 	SoundListener listener;
 
@@ -2231,7 +2349,9 @@ void S_StopChannel(FSoundChan *chan)
 			chan->ChanFlags |= CHAN_FORGETTABLE;
 			if (chan->SourceType == SOURCE_Actor)
 			{
+				S_UnindexChannel(chan);
 				chan->Actor = NULL;
+				S_IndexChannel(chan);
 			}
 		}
 		GSnd->StopChannel(chan);
@@ -2336,6 +2456,7 @@ void S_SerializeSounds(FSerializer &arc)
 			{
 				chan = (FSoundChan*)S_GetChannel(NULL);
 				arc(nullptr, *chan);
+				S_IndexChannel(chan);
 				// Sounds always start out evicted when restored from a save.
 				chan->ChanFlags |= CHAN_EVICTED | CHAN_ABSTIME;
 			}
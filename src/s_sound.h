@@ -187,6 +187,10 @@ struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
 	FSoundChan **PrevChan;	// Previous channel in this list.
+	FSoundChan	*NextSourceChan;	// Next channel in this source hash chain.
+	FSoundChan **PrevSourceChan;	// Previous channel in this source hash chain.
+	FSoundChan	*NextSfxChan;		// Next channel in this sound hash chain.
+	FSoundChan **PrevSfxChan;		// Previous channel in this sound hash chain.
 	FSoundID	SoundID;	// Sound ID of playing sound.
 	FSoundID	OrgID;		// Sound ID of sound used to start this channel.
 	float		Volume;
@@ -323,6 +323,51 @@ const FScanner::SavedPos FScanner::SavePos ()
 	return pos;
 }
 
+//==========================================================================
+//
+// FScanner :: GetSourceText
+//
+// Returns the raw script text between two saved positions.
+//
+//==========================================================================
+
+FString FScanner::GetSourceText(const SavedPos &start, const SavedPos &end) const
+{
+	if (start.SavedScriptPtr == NULL || end.SavedScriptPtr == NULL || end.SavedScriptPtr < start.SavedScriptPtr)
+	{
+		return FString();
+	}
+	return FString(start.SavedScriptPtr, end.SavedScriptPtr - start.SavedScriptPtr);
+}
+
+//==========================================================================
+//
+// FScanner :: GetRawPos
+//
+// Returns the location of the next unread character, taking an ungotten
+// token into account, so that a specialized parser can scan the raw text
+// itself and continue with RestorePos afterward. Returns a NULL pointer if
+// the script has been exhausted.
+//
+//==========================================================================
+
+const FScanner::SavedPos FScanner::GetRawPos () const
+{
+	SavedPos pos;
+
+	if (AlreadyGot)
+	{
+		pos.SavedScriptPtr = LastGotPtr;
+		pos.SavedScriptLine = LastGotLine;
+	}
+	else
+	{
+		pos.SavedScriptPtr = End ? NULL : ScriptPtr;
+		pos.SavedScriptLine = Line;
+	}
+	return pos;
+}
+
 //==========================================================================
 //
 // FScanner :: RestorePos
@@ -31,6 +31,9 @@ public:
 	void DisableStateOptions();
 	const SavedPos SavePos();
 	void RestorePos(const SavedPos &pos);
+	FString GetSourceText(const SavedPos &start, const SavedPos &end) const;
+	const SavedPos GetRawPos() const;
+	const char *GetRawEnd() const { return ScriptEndPtr; }
 
 	static FString TokenName(int token, const char *string=NULL);
 
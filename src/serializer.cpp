@@ -1104,7 +1104,7 @@ const char *FSerializer::GetOutput(unsigned *len)
 //
 //==========================================================================
 
-FCompressedBuffer FSerializer::GetCompressedOutput()
+FCompressedBuffer FSerializer::GetCompressedOutput(int level)
 {
 	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
@@ -1119,6 +1119,12 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	z_stream stream;
 	int err;
 
+	// Level 0 stores the output uncompressed, the same way as a failed compression.
+	if (level <= 0)
+	{
+		goto error;
+	}
+
 	stream.next_in = (Bytef *)w->mOutString.GetString();
 	stream.avail_in = buff.mSize;
 	stream.next_out = (Bytef*)compressbuf;
@@ -1128,7 +1134,7 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	stream.opaque = (voidpf)0;
 
 	// create output in zip-compatible form as required by FCompressedBuffer
-	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+	err = deflateInit2(&stream, level, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
 	if (err != Z_OK)
 	{
 		goto error;
@@ -1154,6 +1160,7 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 
 error:
 	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
+	buff.mBuffer = (char*)compressbuf;
 	buff.mCompressedSize = buff.mSize;
 	buff.mMethod = METHOD_STORED;
 	return buff;
@@ -1746,7 +1753,7 @@ template<> FSerializer &Serialize(FSerializer &arc, const char *key, FDynamicCol
 				const rapidjson::Value &desatval = (*val)[2];
 				if (colorval.IsUint() && fadeval.IsUint() && desatval.IsUint())
 				{
-					cm = GetSpecialLights(colorval.GetUint(), fadeval.GetUint(), desatval.GetUint());
+					cm = GetSpecialLights(colorval.GetUint(), fadeval.GetUint(), desatval.GetUint(), true);
 					return arc;
 				}
 			}
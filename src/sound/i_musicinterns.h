@@ -25,6 +25,8 @@
 #include "s_sound.h"
 #include "files.h"
 #include "wildmidi/wildmidi_lib.h"
+#include <thread>
+#include <atomic>
 
 void I_InitMusicWin32 ();
 void I_ShutdownMusicWin32 ();
@@ -105,6 +107,7 @@ public:
 	virtual void WildMidiSetOption(int opt, int set);
 	virtual bool Preprocess(MIDIStreamer *song, bool looping);
 	virtual FString GetStats();
+	virtual FString GetStreamStats();
 };
 
 // WinMM implementation of a MIDI output device -----------------------------
@@ -238,6 +241,7 @@ public:
 	int Resume();
 	void Stop();
 	bool Pause(bool paused);
+	FString GetStreamStats();
 
 protected:
 	FCriticalSection CritSec;
@@ -250,6 +254,19 @@ protected:
 	bool Started;
 	DWORD Position;
 	int SampleRate;
+	int StreamChunkSize;
+	int StreamChannels;
+
+	// Lookahead rendering: a separate thread keeps a ring buffer filled
+	// so that the stream callback only has to copy samples out of it.
+	std::thread RenderThread;
+	std::atomic<bool> RenderRunning;	// what the stream callback checks, not RenderThread
+	TArray<float> RenderBuffer;
+	std::atomic<unsigned int> RenderReadPos;
+	std::atomic<unsigned int> RenderWritePos;
+	std::atomic<bool> RenderQuit;
+	std::atomic<bool> RenderEnded;
+	std::atomic<unsigned int> Underruns;
 
 	void (*Callback)(unsigned int, void *, DWORD, DWORD);
 	void *CallbackData;
@@ -260,6 +277,11 @@ protected:
 	static bool FillStream(SoundStream *stream, void *buff, int len, void *userdata);
 	virtual bool ServiceStream (void *buff, int numbytes);
 
+	void StartRenderThread();
+	void StopRenderThread();
+	bool RenderAhead();
+	bool ReadRendered(void *buff, int numbytes);
+
 	virtual void HandleEvent(int status, int parm1, int parm2) = 0;
 	virtual void HandleLongEvent(const BYTE *data, int len) = 0;
 	virtual void ComputeOutput(float *buffer, int len) = 0;
@@ -1373,7 +1373,13 @@ FString MIDIStreamer::GetStats()
 	{
 		return "No MIDI device in use.";
 	}
-	return MIDI->GetStats();
+	FString stats = MIDI->GetStats();
+	FString streamstats = MIDI->GetStreamStats();
+	if (streamstats.IsNotEmpty())
+	{
+		stats << '\n' << streamstats;
+	}
+	return stats;
 }
 
 //==========================================================================
@@ -1571,3 +1577,16 @@ FString MIDIDevice::GetStats()
 {
 	return "This MIDI device does not have any stats.";
 }
+
+//==========================================================================
+//
+// MIDIDevice :: GetStreamStats
+//
+// Stats about how the device feeds its output stream, if it has any.
+//
+//==========================================================================
+
+FString MIDIDevice::GetStreamStats()
+{
+	return FString();
+}
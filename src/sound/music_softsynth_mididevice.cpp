@@ -60,6 +60,11 @@
 
 CVAR(Bool, synth_watch, false, 0)
 
+// How many milliseconds of output to render ahead of playback on a separate
+// thread. 0 renders directly inside the stream callback. Takes effect the
+// next time a song starts.
+CVAR(Int, snd_midilookahead, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
 // CODE --------------------------------------------------------------------
 
 //==========================================================================
@@ -76,6 +81,14 @@ SoftSynthMIDIDevice::SoftSynthMIDIDevice()
 	Events = NULL;
 	Started = false;
 	SampleRate = GSnd != NULL ? (int)GSnd->GetOutputRate() : 44100;
+	StreamChunkSize = 0;
+	StreamChannels = 2;
+	RenderReadPos = 0;
+	RenderWritePos = 0;
+	RenderRunning = false;
+	RenderQuit = false;
+	RenderEnded = false;
+	Underruns = 0;
 }
 
 //==========================================================================
@@ -98,10 +111,13 @@ SoftSynthMIDIDevice::~SoftSynthMIDIDevice()
 int SoftSynthMIDIDevice::OpenStream(int chunks, int flags, void (*callback)(unsigned int, void *, DWORD, DWORD), void *userdata)
 {
 	int chunksize = (SampleRate / chunks) * 4;
+	StreamChannels = 1;
 	if (!(flags & SoundStream::Mono))
 	{
 		chunksize *= 2;
+		StreamChannels = 2;
 	}
+	StreamChunkSize = chunksize;
 	Stream = GSnd->CreateStream(FillStream, chunksize, SoundStream::Float | flags, SampleRate, this);
 	if (Stream == NULL)
 	{
@@ -124,6 +140,7 @@ int SoftSynthMIDIDevice::OpenStream(int chunks, int flags, void (*callback)(unsi
 
 void SoftSynthMIDIDevice::Close()
 {
+	StopRenderThread();
 	if (Stream != NULL)
 	{
 		delete Stream;
@@ -204,11 +221,16 @@ int SoftSynthMIDIDevice::Resume()
 {
 	if (!Started)
 	{
+		if (snd_midilookahead > 0)
+		{
+			StartRenderThread();
+		}
 		if (Stream->Play(true, 1))
 		{
 			Started = true;
 			return 0;
 		}
+		StopRenderThread();
 		return 1;
 	}
 	return 0;
@@ -227,6 +249,7 @@ void SoftSynthMIDIDevice::Stop()
 		Stream->Stop();
 		Started = false;
 	}
+	StopRenderThread();
 }
 
 //==========================================================================
@@ -450,5 +473,164 @@ bool SoftSynthMIDIDevice::ServiceStream (void *buff, int numbytes)
 bool SoftSynthMIDIDevice::FillStream(SoundStream *stream, void *buff, int len, void *userdata)
 {
 	SoftSynthMIDIDevice *device = (SoftSynthMIDIDevice *)userdata;
+	if (device->RenderRunning)
+	{
+		return device->ReadRendered(buff, len);
+	}
 	return device->ServiceStream(buff, len);
 }
+
+//==========================================================================
+//
+// SoftSynthMIDIDevice :: StartRenderThread
+//
+// Sizes the ring buffer for snd_midilookahead, fills it and starts the
+// thread that keeps it filled. The buffer always holds whole stream
+// chunks, so a chunk is never split across the wrap point.
+//
+//==========================================================================
+
+void SoftSynthMIDIDevice::StartRenderThread()
+{
+	StopRenderThread();
+	if (StreamChunkSize <= 0)
+	{
+		return;
+	}
+
+	unsigned int chunkfloats = StreamChunkSize / sizeof(float);
+	unsigned int lookahead = unsigned(MIN<int>(snd_midilookahead, 2000)) * SampleRate / 1000 * StreamChannels;
+	unsigned int numchunks = MAX(2u, (lookahead + chunkfloats - 1) / chunkfloats);
+
+	// One extra chunk, because a completely full ring would look empty.
+	RenderBuffer.Resize((numchunks + 1) * chunkfloats);
+	RenderReadPos = 0;
+	RenderWritePos = 0;
+	RenderQuit = false;
+	RenderEnded = false;
+	Underruns = 0;
+
+	// Prefill, so that playback does not start with an underrun.
+	while (RenderAhead())
+	{ }
+
+	RenderRunning = true;
+	RenderThread = std::thread([this]()
+	{
+		while (!RenderQuit)
+		{
+			if (!RenderAhead())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+		}
+	});
+}
+
+//==========================================================================
+//
+// SoftSynthMIDIDevice :: StopRenderThread
+//
+//==========================================================================
+
+void SoftSynthMIDIDevice::StopRenderThread()
+{
+	// The stream callback runs on another thread, so it must stop reading
+	// the ring buffer before the thread goes away. The buffer itself is
+	// kept, in case a callback is still copying out of it.
+	RenderRunning = false;
+	if (RenderThread.joinable())
+	{
+		RenderQuit = true;
+		RenderThread.join();
+	}
+}
+
+//==========================================================================
+//
+// SoftSynthMIDIDevice :: RenderAhead
+//
+// Renders one stream chunk into the ring buffer if there is room for it.
+// Returns false if nothing was rendered.
+//
+//==========================================================================
+
+bool SoftSynthMIDIDevice::RenderAhead()
+{
+	unsigned int size = RenderBuffer.Size();
+	unsigned int chunkfloats = StreamChunkSize / sizeof(float);
+	unsigned int writepos = RenderWritePos.load(std::memory_order_relaxed);
+	unsigned int readpos = RenderReadPos.load(std::memory_order_acquire);
+	unsigned int used = (writepos + size - readpos) % size;
+
+	if (RenderEnded || size - 1 - used < chunkfloats)
+	{
+		return false;
+	}
+	bool more = ServiceStream(&RenderBuffer[writepos], StreamChunkSize);
+	RenderWritePos.store((writepos + chunkfloats) % size, std::memory_order_release);
+	if (!more)
+	{
+		RenderEnded = true;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// SoftSynthMIDIDevice :: ReadRendered
+//
+// Stream callback side of the lookahead buffer. If the render thread has
+// fallen behind, the missing part is filled with silence and counted as
+// an underrun.
+//
+//==========================================================================
+
+bool SoftSynthMIDIDevice::ReadRendered(void *buff, int numbytes)
+{
+	float *out = (float *)buff;
+	unsigned int size = RenderBuffer.Size();
+	unsigned int want = numbytes / sizeof(float);
+	bool ended = RenderEnded;
+	unsigned int readpos = RenderReadPos.load(std::memory_order_relaxed);
+	unsigned int writepos = RenderWritePos.load(std::memory_order_acquire);
+	unsigned int avail = (writepos + size - readpos) % size;
+	unsigned int count = MIN(want, avail);
+	unsigned int first = MIN(count, size - readpos);
+
+	memcpy(out, &RenderBuffer[readpos], first * sizeof(float));
+	memcpy(out + first, &RenderBuffer[0], (count - first) * sizeof(float));
+	RenderReadPos.store((readpos + count) % size, std::memory_order_release);
+
+	if (count < want)
+	{
+		memset(out + count, 0, (want - count) * sizeof(float));
+		if (!ended)
+		{
+			Underruns++;
+		}
+	}
+	return !(ended && count == avail);
+}
+
+//==========================================================================
+//
+// SoftSynthMIDIDevice :: GetStreamStats
+//
+//==========================================================================
+
+FString SoftSynthMIDIDevice::GetStreamStats()
+{
+	FString out;
+
+	if (RenderRunning)
+	{
+		unsigned int size = RenderBuffer.Size();
+		unsigned int avail = (RenderWritePos + size - RenderReadPos) % size;
+		out.Format("Lookahead: %u/%u ms buffered, %u underruns",
+			unsigned(avail * 1000ull / (SampleRate * StreamChannels)),
+			unsigned((size - 1) * 1000ull / (SampleRate * StreamChannels)),
+			Underruns.load());
+	}
+	return out;
+}
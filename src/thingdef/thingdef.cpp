@@ -295,6 +295,10 @@ static void FinishThingdef()
 	unsigned i;
 	int codesize = 0;
 	FILE *dump = NULL;
+	// Big mods repeat the same parameterized action call all over a class's
+	// states. Those only need to be resolved and compiled once per class.
+	TMap<FString, VMFunction *> compiledcalls;
+	FString callkey;
 
 	if (Args->CheckParm("-dumpdisasm")) dump = fopen("disasm.txt", "w");
 
@@ -305,6 +309,24 @@ static void FinishThingdef()
 
 		assert(tcall->Code != NULL);
 
+		if (tcall->Source.IsNotEmpty())
+		{
+			callkey.Format("%p:", tcall->ActorClass);
+			callkey += tcall->Source;
+
+			VMFunction **compiled = compiledcalls.CheckKey(callkey);
+			if (compiled != nullptr)
+			{
+				delete tcall->Code;
+				tcall->Code = nullptr;
+				for (int k = 0; k < tcall->NumStates; ++k)
+				{
+					tcall->ActorClass->OwnedStates[tcall->FirstState + k].SetAction(*compiled);
+				}
+				continue;
+			}
+		}
+
 		// We don't know the return type in advance for anonymous functions.
 		FCompileContext ctx(tcall->ActorClass, nullptr);
 		tcall->Code = tcall->Code->Resolve(ctx);
@@ -350,6 +372,10 @@ static void FinishThingdef()
 				}
 			}
 
+			if (tcall->Source.IsNotEmpty())
+			{
+				compiledcalls[callkey] = func;
+			}
 			delete tcall->Code;
 			tcall->Code = nullptr;
 			for (int k = 0; k < tcall->NumStates; ++k)
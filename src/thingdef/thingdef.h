@@ -72,6 +72,7 @@ class FStateDefinitions
 	FState *laststate;
 	FState *laststatebeforelabel;
 	intptr_t lastlabel;
+	int numindexjumps;
 	TArray<FState> StateArray;
 
 	static FStateDefine *FindStateLabelInList(TArray<FStateDefine> &list, FName name, bool create);
@@ -92,6 +93,7 @@ public:
 		laststate = NULL;
 		laststatebeforelabel = NULL;
 		lastlabel = -1;
+		numindexjumps = 0;
 	}
 
 	void SetStateLabel(const char *statename, FState *state, BYTE defflags = SDF_STATE);
@@ -110,6 +112,11 @@ public:
 	bool SetLoop();
 	int AddStates(FState *state, const char *framechars);
 	int GetStateCount() const { return StateArray.Size(); }
+
+	// Jump offsets are turned into absolute state indices at parse time,
+	// which makes the containing action code position dependent.
+	void AddIndexJump() { numindexjumps++; }
+	int GetIndexJumpCount() const { return numindexjumps; }
 };
 
 //==========================================================================
@@ -127,6 +134,7 @@ struct FStateTempCall
 	class PPrototype *Proto;
 	int FirstState;
 	int NumStates;
+	FString Source;		// Action source text if the code can be shared with identical calls in the same class
 };
 extern TDeletingArray<FStateTempCall *> StateTempCalls;
 extern TDeletingArray<class FxExpression *> ActorDamageFuncs;
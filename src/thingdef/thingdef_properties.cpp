@@ -1627,8 +1627,7 @@ DEFINE_PROPERTY(riplevelmax, I, Actor)
 DEFINE_PROPERTY(distancecheck, S, Actor)
 {
 	PROP_STRING_PARM(cvar, 0);
-	FBaseCVar *scratch;
-	FBaseCVar *cv = FindCVar(cvar, &scratch);
+	FBaseCVar *cv = FindCVar(cvar, NULL);
 	if (cv == NULL)
 	{
 		I_Error("CVar %s not defined", cvar);
@@ -315,11 +315,23 @@ do_stop:
 				}
 
 				bool hasfinalret;
+				FString actionname = sc.String;
+				FScanner::SavedPos actionstart = sc.SavePos();
+				int indexjumps = bag.statedef.GetIndexJumpCount();
+
 				tcall->Code = ParseActions(sc, state, statestring, bag, hasfinalret);
 				if (!hasfinalret && tcall->Code != nullptr)
 				{
 					static_cast<FxSequence *>(tcall->Code)->Add(new FxReturnStatement(nullptr, sc));
 				}
+				if (bag.statedef.GetIndexJumpCount() == indexjumps)
+				{
+					FString actionargs = sc.GetSourceText(actionstart, sc.SavePos());
+					if (actionargs.IsNotEmpty())
+					{
+						tcall->Source = actionname + actionargs;
+					}
+				}
 				goto endofstate;
 			}
 			sc.UnGet();
@@ -656,6 +668,7 @@ void ParseFunctionParameters(FScanner &sc, PClassActor *cls, TArray<FxExpression
 			if (v > 0)
 			{
 				x = new FxStateByIndex(statedef->GetStateCount() + v, sc);
+				statedef->AddIndexJump();
 			}
 			else
 			{
@@ -28,6 +28,9 @@
 #include "timidity.h"
 #include "templates.h"
 #include "c_cvars.h"
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
 namespace Timidity
 {
@@ -411,6 +414,53 @@ static void update_tremolo(Voice *v)
 	volumes on average the lower the higher the tremolo amplitude. */
 }
 
+/* Mix count mono samples into an interleaved stereo buffer. */
+static inline void mix_stereo_run(const sample_t *&sp, float *&lp, final_volume_t left, final_volume_t right, int count)
+{
+#ifndef NO_SSE
+	const __m128 amp = _mm_setr_ps(left, right, left, right);
+
+	while (count >= 4)
+	{
+		__m128 s = _mm_loadu_ps(sp);
+		__m128 lo = _mm_mul_ps(_mm_unpacklo_ps(s, s), amp);
+		__m128 hi = _mm_mul_ps(_mm_unpackhi_ps(s, s), amp);
+		_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), lo));
+		_mm_storeu_ps(lp + 4, _mm_add_ps(_mm_loadu_ps(lp + 4), hi));
+		sp += 4;
+		lp += 8;
+		count -= 4;
+	}
+#endif
+	while (count--)
+	{
+		sample_t s = *sp++;
+		lp[0] += s * left;
+		lp[1] += s * right;
+		lp += 2;
+	}
+}
+
+/* Mix count samples into a mono buffer. */
+static inline void mix_mono_run(const sample_t *&sp, float *&lp, final_volume_t amp, int count)
+{
+#ifndef NO_SSE
+	const __m128 amp4 = _mm_set1_ps(amp);
+
+	while (count >= 4)
+	{
+		_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), _mm_mul_ps(_mm_loadu_ps(sp), amp4)));
+		sp += 4;
+		lp += 4;
+		count -= 4;
+	}
+#endif
+	while (count--)
+	{
+		*lp++ += *sp++ * amp;
+	}
+}
+
 /* Returns 1 if the note died */
 static int update_signal(Voice *v)
 {
@@ -432,7 +482,6 @@ static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *
 		left = v->left_mix, 
 		right = v->right_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = v->control_counter))
 	{
@@ -449,13 +498,7 @@ static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_stereo_run(sp, lp, left, right, cc);
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -465,13 +508,7 @@ static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_stereo_run(sp, lp, left, right, count);
 			return;
 		}
 	}
@@ -547,10 +584,7 @@ static void mix_mono_signal(SDWORD control_ratio, const sample_t *sp, float *lp,
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				*lp++ += *sp++ * left;
-			}
+			mix_mono_run(sp, lp, left, cc);
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -559,10 +593,7 @@ static void mix_mono_signal(SDWORD control_ratio, const sample_t *sp, float *lp,
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				*lp++ += *sp++ * left;
-			}
+			mix_mono_run(sp, lp, left, count);
 			return;
 		}
 	}
@@ -570,18 +601,7 @@ static void mix_mono_signal(SDWORD control_ratio, const sample_t *sp, float *lp,
 
 static void mix_mystery(SDWORD control_ratio, const sample_t *sp, float *lp, Voice *v, int count)
 {
-	final_volume_t 
-		left = v->left_mix, 
-		right = v->right_mix;
-	sample_t s;
-
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += s * left;
-		lp[1] += s * right;
-		lp += 2;
-	}
+	mix_stereo_run(sp, lp, v->left_mix, v->right_mix, count);
 }
 
 static void mix_single(const sample_t *sp, float *lp, final_volume_t amp, int count)
@@ -604,13 +624,7 @@ static void mix_single_right(const sample_t *sp, float *lp, Voice *v, int count)
 
 static void mix_mono(const sample_t *sp, float *lp, Voice *v, int count)
 {
-	final_volume_t 
-		left = v->left_mix;
-
-	while (count--)
-	{
-		*lp++ += *sp++ * left;
-	}
+	mix_mono_run(sp, lp, v->left_mix, count);
 }
 
 /* Ramp a note out in c samples */
@@ -27,6 +27,9 @@
 
 #include "timidity.h"
 #include "c_cvars.h"
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
 namespace Timidity
 {
@@ -39,6 +42,37 @@ namespace Timidity
 #define FINALINTERP if (ofs == le) *dest++ = src[ofs >> FRACTION_BITS];
 /* So it isn't interpolation. At least it's final. */
 
+/* Runs RESAMPLATION count times with a fixed increment and returns the new
+   offset. The SSE2 version does the interpolation math four samples at a
+   time and produces the same results as the scalar macro. */
+static inline int resample_fixed(sample_t *&dest, const sample_t *src, int ofs, int incr, int count)
+{
+#ifndef NO_SSE
+	const __m128 fracscale = _mm_set1_ps(float(1 << FRACTION_BITS));
+
+	while (count >= 4)
+	{
+		int o0 = ofs >> FRACTION_BITS, o1 = (ofs + incr) >> FRACTION_BITS;
+		int o2 = (ofs + incr*2) >> FRACTION_BITS, o3 = (ofs + incr*3) >> FRACTION_BITS;
+		__m128i m = _mm_setr_epi32(ofs & FRACTION_MASK, (ofs + incr) & FRACTION_MASK,
+			(ofs + incr*2) & FRACTION_MASK, (ofs + incr*3) & FRACTION_MASK);
+		__m128 a = _mm_setr_ps(src[o0], src[o1], src[o2], src[o3]);
+		__m128 b = _mm_setr_ps(src[o0 + 1], src[o1 + 1], src[o2 + 1], src[o3 + 1]);
+		__m128 delta = _mm_div_ps(_mm_mul_ps(_mm_sub_ps(b, a), _mm_cvtepi32_ps(m)), fracscale);
+		_mm_storeu_ps(dest, _mm_add_ps(a, delta));
+		dest += 4;
+		ofs += incr*4;
+		count -= 4;
+	}
+#endif
+	while (count--)
+	{
+		RESAMPLATION;
+		ofs += incr;
+	}
+	return ofs;
+}
+
 /*************** resampling with fixed increment *****************/
 
 static sample_t *rs_plain(sample_t *resample_buffer, Voice *v, int *countptr)
@@ -73,11 +107,7 @@ static sample_t *rs_plain(sample_t *resample_buffer, Voice *v, int *countptr)
 		count -= i;
 	}
 
-	while (i--) 
-	{
-		RESAMPLATION;
-		ofs += incr;
-	}
+	ofs = resample_fixed(dest, src, ofs, incr, i);
 
 	if (ofs >= le) 
 	{
@@ -122,11 +152,7 @@ static sample_t *rs_loop(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 	}
 
 	vp->sample_offset=ofs; /* Update offset */
@@ -166,11 +192,7 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 	}
 
 	/* Then do the bidirectional looping */
@@ -188,11 +210,7 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 		if (ofs >= le) 
 		{
 			/* fold the overshoot back in */
@@ -361,11 +379,7 @@ static sample_t *rs_vib_loop(sample_t *resample_buffer, float rate, Voice *vp, i
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -419,11 +433,7 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -452,11 +462,7 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_fixed(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -130,6 +130,76 @@ void DCanvas::DrawTexture (FTexture *img, double x, double y, int tags_first, ..
 	DrawTextureParms(img, parms);
 }
 
+//==========================================================================
+//
+// DCanvas :: ParseDrawParms
+//
+// For code like SBARINFO's string drawing that positions each character
+// itself and would otherwise parse the same tag list for every one.
+//
+//==========================================================================
+
+bool DCanvas::ParseDrawParms (DrawParms *parms, int tags_first, ...) const
+{
+	va_list tags;
+	va_start(tags, tags_first);
+	bool res = ParseDrawTextureTags(nullptr, 0, 0, tags_first, tags, parms, true);
+	va_end(tags);
+	return res;
+}
+
+//==========================================================================
+//
+// DCanvas :: DrawTextureResolved
+//
+//==========================================================================
+
+void DCanvas::DrawTextureResolved (FTexture *img, double x, double y, double w, double h, const DrawParms &resolved)
+{
+	if (img == NULL || img->UseType == FTexture::TEX_Null || w <= 0 || h <= 0)
+	{
+		return;
+	}
+	if (x < -16383 || x > 16383 || y < -16383 || y > 16383)
+	{
+		return;
+	}
+
+	// DrawTextureParms may change the parameters it is given.
+	DrawParms parms = resolved;
+	parms.x = x;
+	parms.y = y;
+	parms.texwidth = img->GetScaledWidthDouble();
+	parms.texheight = img->GetScaledHeightDouble();
+	parms.left = img->GetScaledLeftOffset();
+	parms.top = img->GetScaledTopOffset();
+	parms.destwidth = w;
+	parms.destheight = h;
+	DrawTextureParms(img, parms);
+}
+
+//==========================================================================
+//
+// DCanvas :: BeginBatch2D
+//
+//==========================================================================
+
+void DCanvas::BeginBatch2D ()
+{
+	DrawerCommandQueue::Begin();
+}
+
+//==========================================================================
+//
+// DCanvas :: EndBatch2D
+//
+//==========================================================================
+
+void DCanvas::EndBatch2D ()
+{
+	DrawerCommandQueue::End();
+}
+
 void DCanvas::DrawTextureParms(FTexture *img, DrawParms &parms)
 {
 #ifndef NO_SWRENDER
@@ -1066,6 +1136,8 @@ void DCanvas::PUTTRANSDOT (int xx, int yy, int basecolor, int level)
 void DCanvas::DrawLine(int x0, int y0, int x1, int y1, int palColor, uint32 realcolor)
 //void DrawTransWuLine (int x0, int y0, int x1, int y1, BYTE palColor)
 {
+	DrawerCommandQueue::WaitForWorkers();
+
 	const int WeightingScale = 0;
 	const int WEIGHTBITS = 6;
 	const int WEIGHTSHIFT = 16-WEIGHTBITS;
@@ -1263,6 +1335,8 @@ void DCanvas::DrawLine(int x0, int y0, int x1, int y1, int palColor, uint32 real
 
 void DCanvas::DrawPixel(int x, int y, int palColor, uint32 realcolor)
 {
+	DrawerCommandQueue::WaitForWorkers();
+
 	if (palColor < 0)
 	{
 		palColor = PalFromRGB(realcolor);
@@ -1281,6 +1355,8 @@ void DCanvas::DrawPixel(int x, int y, int palColor, uint32 realcolor)
 
 void DCanvas::Clear (int left, int top, int right, int bottom, int palcolor, uint32 color)
 {
+	DrawerCommandQueue::WaitForWorkers();
+
 	int x, y;
 
 	if (left == right || top == bottom)
@@ -1565,6 +1641,8 @@ void DCanvas::FillSimplePoly(FTexture *tex, FVector2 *points, int npoints,
 //
 void DCanvas::DrawBlock (int x, int y, int _width, int _height, const BYTE *src) const
 {
+	DrawerCommandQueue::WaitForWorkers();
+
 	if (IsBgra())
 		return;
 
@@ -1594,6 +1672,8 @@ void DCanvas::DrawBlock (int x, int y, int _width, int _height, const BYTE *src)
 //
 void DCanvas::GetBlock (int x, int y, int _width, int _height, BYTE *dest) const
 {
+	DrawerCommandQueue::WaitForWorkers();
+
 	if (IsBgra())
 		return;
 
@@ -62,6 +62,7 @@
 #include "r_sky.h"
 #include "r_utility.h"
 #include "r_renderer.h"
+#include "r_draw_rgba.h"
 #include "menu/menu.h"
 #include "r_data/voxels.h"
 
@@ -348,6 +349,8 @@ void DCanvas::Dim (PalEntry color, float damount, int x1, int y1, int w, int h)
 	if (damount == 0.f)
 		return;
 
+	DrawerCommandQueue::WaitForWorkers();
+
 	int gap;
 	int x, y;
 
@@ -449,6 +452,7 @@ void DCanvas::Dim (PalEntry color, float damount, int x1, int y1, int w, int h)
 
 void DCanvas::GetScreenshotBuffer(const BYTE *&buffer, int &pitch, ESSType &color_type)
 {
+	DrawerCommandQueue::WaitForWorkers();
 	Lock(true);
 	buffer = GetBuffer();
 	pitch = IsBgra() ? GetPitch() * 4 : GetPitch();
@@ -905,65 +909,19 @@ DFrameBuffer::DFrameBuffer (int width, int height, bool bgra)
 
 //==========================================================================
 //
-// DFrameBuffer :: PostprocessBgra
+// DFrameBuffer :: CopyWithGammaBgra
 //
 // Copies data to destination buffer while performing gamma and flash.
-// This is only needed if a target cannot do this with shaders.
+// This is only needed if a target cannot do this with shaders. The rows
+// are split between the drawer threads when r_multithreaded is on.
 //
 //==========================================================================
 
 void DFrameBuffer::CopyWithGammaBgra(void *output, int pitch, const BYTE *gammared, const BYTE *gammagreen, const BYTE *gammablue, PalEntry flash, int flash_amount)
 {
-	const BYTE *gammatables[3] = { gammared, gammagreen, gammablue };
-
-	if (flash_amount > 0)
-	{
-		uint16_t inv_flash_amount = 256 - flash_amount;
-		uint16_t flash_red = flash.r * flash_amount;
-		uint16_t flash_green = flash.g * flash_amount;
-		uint16_t flash_blue = flash.b * flash_amount;
-		
-		for (int y = 0; y < Height; y++)
-		{
-			BYTE *dest = (BYTE*)output + y * pitch;
-			BYTE *src = MemBuffer + y * Pitch * 4;
-			for (int x = 0;  x < Width; x++)
-			{
-				uint16_t fg_red = src[2];
-				uint16_t fg_green = src[1];
-				uint16_t fg_blue = src[0];
-				uint16_t red = (fg_red * inv_flash_amount + flash_red) >> 8;
-				uint16_t green = (fg_green * inv_flash_amount + flash_green) >> 8;
-				uint16_t blue = (fg_blue * inv_flash_amount + flash_blue) >> 8;
-
-				dest[0] = gammatables[2][blue];
-				dest[1] = gammatables[1][green];
-				dest[2] = gammatables[0][red];
-				dest[3] = 0xff;
-
-				dest += 4;
-				src += 4;
-			}
-		}
-	}
-	else
-	{
-		for (int y = 0; y < Height; y++)
-		{
-			BYTE *dest = (BYTE*)output + y * pitch;
-			BYTE *src = MemBuffer + y * Pitch * 4;
-			for (int x = 0;  x < Width; x++)
-			{
-				dest[0] = gammatables[2][src[0]];
-				dest[1] = gammatables[1][src[1]];
-				dest[2] = gammatables[0][src[2]];
-				dest[3] = 0xff;
-
-				dest += 4;
-				src += 4;
-			}
-		}
-	}
+	DrawerCommandQueue::Begin();
+	DrawerCommandQueue::QueueCommand<CopyWithGammaBgraCommand>(MemBuffer, Pitch, output, pitch, Width, Height, gammared, gammagreen, gammablue, flash, flash_amount);
+	DrawerCommandQueue::End();
 }
 
 
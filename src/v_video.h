@@ -253,6 +253,17 @@ public:
 	// 2D Texture drawing
 	bool SetTextureParms(DrawParms *parms, FTexture *img, double x, double y) const;
 	void DrawTexture (FTexture *img, double x, double y, int tags, ...);
+
+	// Resolves a tag list once for drawing many textures with DrawTextureResolved.
+	// Tags that depend on the texture's size or offsets are not allowed.
+	bool ParseDrawParms (DrawParms *parms, int tags, ...) const;
+	// Draws img at a real screen position and size using parameters from ParseDrawParms
+	void DrawTextureResolved (FTexture *img, double x, double y, double w, double h, const DrawParms &parms);
+
+	// The software drawing of textures and text between these is queued on the
+	// drawer threads. Anything that writes to the canvas directly waits for it.
+	void BeginBatch2D ();
+	void EndBatch2D ();
 	void FillBorder (FTexture *img);	// Fills the border around a 4:3 part of the screen on non-4:3 displays
 	void VirtualToRealCoords(double &x, double &y, double &w, double &h, double vwidth, double vheight, bool vbottom=false, bool handleaspect=true) const;
 
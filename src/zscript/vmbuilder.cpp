@@ -1,4 +1,7 @@
 #include "vmbuilder.h"
+#include "c_cvars.h"
+
+CVAR(Bool, vm_optimize, true, 0)
 
 //==========================================================================
 //
@@ -39,6 +42,10 @@ VMScriptFunction *VMFunctionBuilder::MakeFunction()
 {
 	VMScriptFunction *func = new VMScriptFunction;
 
+	if (vm_optimize)
+	{
+		OptimizeCode();
+	}
 	func->Alloc(Code.Size(), NumIntConstants, NumFloatConstants, NumStringConstants, NumAddressConstants);
 
 	// Copy code block.
@@ -77,6 +84,158 @@ VMScriptFunction *VMFunctionBuilder::MakeFunction()
 	return func;
 }
 
+//==========================================================================
+//
+// VMFunctionBuilder :: OptimizeCode
+//
+// Cleans up the finished code before it is copied into the function.
+// Jumps to jumps are threaded, and code that can never be reached as well
+// as instructions that do nothing are removed. Constants have already been
+// folded by the expression tree, so what is left to do here is mostly the
+// fixed code sequences the emitters produce.
+//
+//==========================================================================
+
+// Instructions that may skip the one following them. That one must stay
+// where it is, because the skip is just a pc++.
+static bool SkipsNext(int op)
+{
+	return op == OP_TEST || op == OP_CMPS || op == OP_CATCH ||
+		(op >= OP_EQ_R && op <= OP_LEU_KR) ||
+		(op >= OP_EQF_R && op <= OP_LEF_KR) ||
+		op == OP_EQV_R || op == OP_EQV_K ||
+		op == OP_EQA_R || op == OP_EQA_K;
+}
+
+// Instructions after which execution never continues with the next one.
+static bool EndsFlow(const VMOP &op)
+{
+	switch (op.op)
+	{
+	case OP_JMP:
+	case OP_IJMP:
+	case OP_TAIL:
+	case OP_TAIL_K:
+	case OP_THROW:
+		return true;
+	case OP_RET:
+		return op.b == REGT_NIL || (op.a & RET_FINAL);
+	case OP_RETI:
+		return !!(op.a & RET_FINAL);
+	default:
+		return false;
+	}
+}
+
+void VMFunctionBuilder::OptimizeCode()
+{
+	unsigned count = Code.Size();
+	bool canremove = true;
+	unsigned i;
+
+	// Thread jumps that land on other jumps. The hop limit keeps a
+	// jump loop from hanging us.
+	for (i = 0; i < count; ++i)
+	{
+		if (Code[i].op == OP_JMP)
+		{
+			unsigned target = i + 1 + Code[i].i24;
+			for (int hops = 0; hops < 8 && target < count && Code[target].op == OP_JMP && target != i; ++hops)
+			{
+				target = target + 1 + Code[target].i24;
+			}
+			Code[i].i24 = int(target - i - 1);
+		}
+		else if (Code[i].op == OP_IJMP || Code[i].op == OP_TRY || Code[i].op == OP_CATCH)
+		{
+			// Jump tables and exception handlers are addressed relative to
+			// their instruction, so nothing may be moved around them.
+			canremove = false;
+		}
+	}
+	if (!canremove || count == 0)
+	{
+		return;
+	}
+
+	// Find out what can be reached.
+	TArray<bool> reachable;
+	TArray<unsigned> work;
+	reachable.Resize(count);
+	memset(&reachable[0], 0, count * sizeof(bool));
+	work.Push(0);
+	while (work.Pop(i))
+	{
+		while (i < count && !reachable[i])
+		{
+			reachable[i] = true;
+			if (Code[i].op == OP_JMP)
+			{
+				i = i + 1 + Code[i].i24;
+				continue;
+			}
+			if (EndsFlow(Code[i]))
+			{
+				break;
+			}
+			if (SkipsNext(Code[i].op))
+			{
+				work.Push(i + 2);
+			}
+			i++;
+		}
+	}
+
+	// Decide what to keep and where it ends up. A removed instruction maps
+	// to the next one that is kept.
+	TArray<bool> keep;
+	TArray<unsigned> newindex;
+	keep.Resize(count);
+	newindex.Resize(count + 1);
+	unsigned kept = 0;
+	for (i = 0; i < count; ++i)
+	{
+		const VMOP &op = Code[i];
+		bool remove = !reachable[i] ||
+			op.op == OP_NOP ||
+			(op.a == op.b && (op.op == OP_MOVE || op.op == OP_MOVEF || op.op == OP_MOVES || op.op == OP_MOVEA)) ||
+			(op.op == OP_JMP && op.i24 == 0);
+
+		if (remove && i > 0 && reachable[i - 1] && SkipsNext(Code[i - 1].op))
+		{
+			remove = false;
+		}
+		keep[i] = !remove;
+		newindex[i] = kept;
+		if (!remove)
+		{
+			kept++;
+		}
+	}
+	if (kept == count)
+	{
+		return;
+	}
+	newindex[count] = kept;
+
+	// Compact the code and retarget the jumps.
+	TArray<VMOP> newcode;
+	newcode.Reserve(kept);
+	for (i = 0; i < count; ++i)
+	{
+		if (keep[i])
+		{
+			VMOP op = Code[i];
+			if (op.op == OP_JMP)
+			{
+				op.i24 = int(newindex[i + 1 + Code[i].i24] - newindex[i] - 1);
+			}
+			newcode[newindex[i]] = op;
+		}
+	}
+	Code = newcode;
+}
+
 //==========================================================================
 //
 // VMFunctionBuilder :: FillIntConstants
@@ -85,6 +85,8 @@ private:
 
 	TArray<VMOP> Code;
 
+	void OptimizeCode();
+
 };
 
 #endif